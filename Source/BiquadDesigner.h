@@ -0,0 +1,261 @@
+/*
+  ==============================================================================
+
+    BiquadDesigner.h
+    Allocation free coefficient design for every band type.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "EQEngine.h"
+
+namespace Dsp
+{
+    namespace BiquadDesigner
+    {
+        /** sin(x) for x in [-pi/2, pi/2]: odd Taylor polynomial up to x^17, evaluated in
+            double. The truncation error is below (pi/2)^19 / 19! ~= 5e-14 over the range,
+            which keeps the poles of low, narrow bells in place even for the double engine.
+        */
+        inline double sinHalfRange (double x) noexcept
+        {
+            const auto x2 = x * x;
+
+            return x * (1.0 + x2 * (-1.0 / 6.0
+                     + x2 * (1.0 / 120.0
+                     + x2 * (-1.0 / 5040.0
+                     + x2 * (1.0 / 362880.0
+                     + x2 * (-1.0 / 39916800.0
+                     + x2 * (1.0 / 6227020800.0
+                     + x2 * (-1.0 / 1307674368000.0
+                     + x2 * (1.0 / 355687428096000.0)))))))));
+        }
+
+        /** sin and cos of an angle in [0, pi], without calling into libm. */
+        inline void sinCos (double w, double& sinW, double& cosW) noexcept
+        {
+            constexpr auto pi = MathConstants<double>::pi;
+            constexpr auto halfPi = MathConstants<double>::halfPi;
+
+            // sin is symmetric about pi/2 and cos(w) == sin(pi/2 - w), which keeps both
+            // arguments inside the range the polynomial covers
+            sinW = sinHalfRange (w <= halfPi ? w : pi - w);
+            cosW = sinHalfRange (halfPi - w);
+        }
+
+        /** RBJ cookbook design through the bilinear transform. Exact at DC and at the centre
+            frequency, but the response is squeezed towards nyquist.
+        */
+        inline void designBilinear (FilterType type, double sampleRate, float frequency, float q, float gain,
+                                    BiquadCoefficients& out) noexcept
+        {
+            if (sampleRate <= 0.0)
+            {
+                jassertfalse;
+                out = {};
+                return;
+            }
+
+            const auto f = jlimit (2.0, sampleRate * 0.4999, (double) frequency);
+            const auto w = MathConstants<double>::twoPi * f / sampleRate;
+
+            double sinW, cosW;
+            sinCos (w, sinW, cosW);
+
+            const auto alpha = sinW / (2.0 * jmax (1.0e-3, (double) q));
+
+            double b0, b1, b2, a0, a1, a2;
+            a1 = -2.0 * cosW;
+
+            switch (type)
+            {
+                case lowCutType:
+                    b0 = (1.0 + cosW) * 0.5;  b1 = -(1.0 + cosW);  b2 = b0;
+                    a0 = 1.0 + alpha;         a2 = 1.0 - alpha;
+                    break;
+
+                case highCutType:
+                    b0 = (1.0 - cosW) * 0.5;  b1 = 1.0 - cosW;     b2 = b0;
+                    a0 = 1.0 + alpha;         a2 = 1.0 - alpha;
+                    break;
+
+                case notchType:
+                    b0 = 1.0;                 b1 = a1;             b2 = 1.0;
+                    a0 = 1.0 + alpha;         a2 = 1.0 - alpha;
+                    break;
+
+                case bandPassType:
+                    b0 = alpha;               b1 = 0.0;            b2 = -alpha;
+                    a0 = 1.0 + alpha;         a2 = 1.0 - alpha;
+                    break;
+
+                case bellType:
+                default:
+                {
+                    const auto A = std::sqrt (jmax (1.0e-6, (double) gain));
+
+                    b0 = 1.0 + alpha * A;     b1 = a1;             b2 = 1.0 - alpha * A;
+                    a0 = 1.0 + alpha / A;     a2 = 1.0 - alpha / A;
+                    break;
+                }
+            }
+
+            const auto norm = 1.0 / a0;
+
+            out.b0 = b0 * norm;
+            out.b1 = b1 * norm;
+            out.b2 = b2 * norm;
+            out.a1 = a1 * norm;
+            out.a2 = a2 * norm;
+        }
+
+        /** Vicanek's matched second order sections ("Matched Second Order Digital Filters", 2016).
+
+            The poles are those of the impulse invariant transform, and the zeros are solved so
+            the magnitude equals the analog prototype's at the points that define each shape:
+            DC and the centre frequency, plus a flat peak there for bells and band passes. The
+            top octave then follows the analog curve to within a dB or two instead of cramping,
+            without raising the sample rate. Bells use the same split of the gain between poles and zeros
+            as the RBJ design, so both paths draw the same curve well below nyquist.
+        */
+        inline void designMatched (FilterType type, double sampleRate, float frequency, float q, float gain,
+                                   BiquadCoefficients& out) noexcept
+        {
+            if (sampleRate <= 0.0)
+            {
+                jassertfalse;
+                out = {};
+                return;
+            }
+
+            const auto f = jlimit (2.0, sampleRate * 0.4999, (double) frequency);
+            const auto w0 = MathConstants<double>::twoPi * f / sampleRate;
+            const auto Q = jmax (1.0e-3, (double) q);
+            const auto G = jmax (1.0e-6, (double) gain);
+
+            // Bells put sqrt (G) / Q on the zeros and 1 / (sqrt (G) Q) on the poles
+            const auto poleQ = type == bellType ? Q * std::sqrt (G) : Q;
+            const auto damping = 1.0 / (2.0 * poleQ);
+
+            double a1;
+            const auto a2 = std::exp (-2.0 * damping * w0);
+
+            if (damping <= 1.0)
+            {
+                double sinW, cosW;
+                sinCos (std::sqrt (1.0 - damping * damping) * w0, sinW, cosW);
+                a1 = -2.0 * std::exp (-damping * w0) * cosW;
+            }
+            else
+            {
+                a1 = -2.0 * std::exp (-damping * w0) * std::cosh (std::sqrt (damping * damping - 1.0) * w0);
+            }
+
+            const auto A0 = square (1.0 + a1 + a2);
+            const auto A1 = square (1.0 - a1 + a2);
+            const auto A2 = -4.0 * a2;
+
+            double sinHalf, cosHalf;
+            sinCos (w0 * 0.5, sinHalf, cosHalf);
+
+            const auto phi1 = sinHalf * sinHalf;
+            const auto phi0 = 1.0 - phi1;
+            const auto phi2 = 4.0 * phi0 * phi1;
+
+            const auto poleResponse = A0 * phi0 + A1 * phi1 + A2 * phi2;
+
+            double b0, b1, b2;
+
+            switch (type)
+            {
+                case lowCutType:
+                {
+                    b0 = std::sqrt (jmax (0.0, poleResponse)) * Q / (4.0 * phi1);
+                    b1 = -2.0 * b0;
+                    b2 = b0;
+                    break;
+                }
+
+                case highCutType:
+                {
+                    const auto R1 = poleResponse * Q * Q;
+                    const auto B0 = A0;
+                    const auto B1 = jmax (0.0, (R1 - B0 * phi0) / phi1);
+
+                    b0 = 0.5 * (std::sqrt (B0) + std::sqrt (B1));
+                    b1 = std::sqrt (B0) - b0;
+                    b2 = 0.0;
+                    break;
+                }
+
+                case bandPassType:
+                {
+                    const auto R1 = poleResponse;
+                    const auto R2 = -A0 + A1 + 4.0 * (phi0 - phi1) * A2;
+                    const auto B2 = (R1 - R2 * phi1) / (4.0 * phi1 * phi1);
+                    const auto B1 = jmax (0.0, R2 + 4.0 * (phi1 - phi0) * B2);
+
+                    b1 = -0.5 * std::sqrt (B1);
+                    b0 = 0.5 * (std::sqrt (jmax (0.0, B2 + b1 * b1)) - b1);
+                    b2 = -b0 - b1;
+                    break;
+                }
+
+                case notchType:
+                {
+                    // Vicanek has no notch; the zeros stay on the unit circle at the centre
+                    // frequency, so the null is exact, and the gain is matched at DC
+                    double sinW, cosW;
+                    sinCos (w0, sinW, cosW);
+
+                    b0 = (1.0 + a1 + a2) / (2.0 - 2.0 * cosW);
+                    b1 = -2.0 * cosW * b0;
+                    b2 = b0;
+                    break;
+                }
+
+                case bellType:
+                default:
+                {
+                    const auto R1 = poleResponse * G * G;
+                    const auto R2 = (-A0 + A1 + 4.0 * (phi0 - phi1) * A2) * G * G;
+                    const auto B0 = A0;
+                    const auto B2 = (R1 - R2 * phi1 - B0) / (4.0 * phi1 * phi1);
+                    const auto B1 = jmax (0.0, R2 + B0 + 4.0 * (phi1 - phi0) * B2);
+                    const auto W = 0.5 * (std::sqrt (B0) + std::sqrt (B1));
+
+                    b0 = 0.5 * (W + std::sqrt (jmax (0.0, W * W + B2)));
+                    b1 = 0.5 * (std::sqrt (B0) - std::sqrt (B1));
+                    b2 = -B2 / (4.0 * b0);
+                    break;
+                }
+            }
+
+            out.b0 = b0;
+            out.b1 = b1;
+            out.b2 = b2;
+            out.a1 = a1;
+            out.a2 = a2;
+        }
+
+        /** Designs one band straight into the given storage. Gain is a linear factor and
+            only used by bells; frequencies are kept safely inside (0, nyquist).
+        */
+        inline void design (FilterType type, DesignMethod method, double sampleRate,
+                            float frequency, float q, float gain, BiquadCoefficients& out) noexcept
+        {
+            if (method == matchedDesign)
+                designMatched (type, sampleRate, frequency, q, gain, out);
+            else
+                designBilinear (type, sampleRate, frequency, q, gain, out);
+        }
+
+        inline void design (const BandParameters& band, DesignMethod method, double sampleRate,
+                            BiquadCoefficients& out) noexcept
+        {
+            design (band.type, method, sampleRate, band.frequency, band.q, band.gain, out);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#include "CurveRenderer.h"
+
+namespace Gui
+{
+	CurveRenderer::CurveRenderer()
+		: Thread("EQ curve renderer")
+	{
+		startThread(Thread::Priority::normal);
+	}
+
+	CurveRenderer::~CurveRenderer()
+	{
+		signalThreadShouldExit();
+		notify();
+		stopThread(2000);
+	}
+
+	void CurveRenderer::submit()
+	{
+		layerExchange.publish();
+		notify();
+	}
+
+	void CurveRenderer::run()
+	{
+		while (!threadShouldExit())
+		{
+			wait(-1);
+
+			if (!layerExchange.pull())
+				continue;
+
+			const auto& layers = layerExchange.getReadBuffer();
+			auto& frame = frameExchange.getWriteBuffer();
+
+			const auto width = jmax(1, roundToInt((float)layers.bounds.getWidth() * layers.scale));
+			const auto height = jmax(1, roundToInt((float)layers.bounds.getHeight() * layers.scale));
+
+			// Software images can be drawn into from any thread; the slot's old image is
+			// reused when the size still fits
+			if (frame.image.isNull() || frame.image.getWidth() != width || frame.image.getHeight() != height)
+				frame.image = Image(Image::ARGB, width, height, true, SoftwareImageType());
+			else
+				frame.image.clear(frame.image.getBounds());
+
+			{
+				Graphics g(frame.image);
+				g.addTransform(AffineTransform::scale(layers.scale));
+				drawLayers(g, layers);
+			}
+
+			frame.sequence = layers.sequence;
+			frameExchange.publish();
+		}
+	}
+
+	void CurveRenderer::drawLayers(Graphics& g, const Layers& layers)
+	{
+		using Analyzer = Dsp::SpectrumAnalyzer;
+
+		if (layers.hasSpectrum)
+		{
+			// 处理前：灰色填充；处理后：浅蓝色曲线；峰值保持用细线
+			g.setColour(Colours::grey.withAlpha(0.35f));
+			g.strokePath(layers.peakCurves[Analyzer::preTap], PathStrokeType(1.f));
+			g.setColour(Colours::lightblue.withAlpha(0.5f));
+			g.strokePath(layers.peakCurves[Analyzer::postTap], PathStrokeType(1.f));
+
+			auto preFill = layers.spectrumCurves[Analyzer::preTap];
+			const auto bounds = preFill.getBounds();
+			preFill.lineTo(bounds.getRight(), layers.plotArea.getBottom());
+			preFill.lineTo(bounds.getX(), layers.plotArea.getBottom());
+			preFill.closeSubPath();
+
+			g.setColour(Colours::grey.withAlpha(0.35f));
+			g.fillPath(preFill);
+
+			g.setColour(Colours::lightblue);
+			g.strokePath(layers.spectrumCurves[Analyzer::postTap], PathStrokeType(1.5f));
+		}
+
+		g.setColour(Colours::orange);
+		g.strokePath(layers.responseCurve, PathStrokeType(2.f));
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectrumAnalyzer.h"
+#include "TripleBuffer.h"
+
+namespace Gui
+{
+	/**
+		Rasterises the dynamic layers of the response curve display, the EQ curve and the
+		analyzer traces, on its own thread.
+
+		The message thread fills in the paths and submits them; the render thread strokes them
+		into a transparent software image and publishes it. Both directions go through a
+		TripleBuffer, so a submission the thread hasn't started on is replaced by the next one
+		and a frame nobody has picked up is replaced by a newer one; nothing ever queues up and
+		the message thread never waits.
+	*/
+	class CurveRenderer : private Thread
+	{
+	public:
+		struct Layers
+		{
+			Path responseCurve;
+			std::array<Path, Dsp::SpectrumAnalyzer::numTaps> spectrumCurves, peakCurves;
+			bool hasSpectrum = false;
+
+			Rectangle<int> bounds;
+			Rectangle<float> plotArea;
+			float scale = 1.0f;
+			uint32 sequence = 0;
+		};
+
+		struct Frame
+		{
+			Image image;
+			uint32 sequence = 0;
+		};
+
+		CurveRenderer();
+		~CurveRenderer() override;
+
+		/** Message thread: the layers to fill in completely before calling submit(). */
+		Layers& getLayersToSubmit() noexcept { return layerExchange.getWriteBuffer(); }
+		void submit();
+
+		/** Message thread: takes the newest finished frame. @returns true if there was a new one. */
+		bool pullFrame() noexcept { return frameExchange.pull(); }
+		const Frame& getFrame() const noexcept { return frameExchange.getReadBuffer(); }
+
+	private:
+		void run() override;
+
+		static void drawLayers(Graphics& g, const Layers& layers);
+
+		Dsp::TripleBuffer<Layers> layerExchange;
+		Dsp::TripleBuffer<Frame> frameExchange;
+
+		JUCE_DECLARE_NON_COPYABLE(CurveRenderer)
+	};
+}
@@ -0,0 +1,447 @@
+/*
+  ==============================================================================
+
+    EQEngine.cpp
+    SIMD biquad cascade shared by every channel of the EQ.
+
+  ==============================================================================
+*/
+
+#include "EQEngine.h"
+#include "BiquadDesigner.h"
+
+namespace Dsp
+{
+    double BiquadCoefficients::getMagnitudeForFrequency (double frequency, double sampleRate) const
+    {
+        const auto w = MathConstants<double>::twoPi * frequency / sampleRate;
+        const auto z1 = std::polar (1.0, -w);
+        const auto z2 = z1 * z1;
+
+        const auto numerator   = b0 + b1 * z1 + b2 * z2;
+        const auto denominator = 1.0 + a1 * z1 + a2 * z2;
+
+        return std::abs (numerator / denominator);
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    void EQEngine<SampleType>::prepare (const dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+
+        const auto numGroups = (spec.numChannels + Vec::size() - 1) / Vec::size();
+        groups.resize (jmax ((size_t) 1, (size_t) numGroups));
+
+        resetMulticoreTimings();
+
+        for (auto& s : smoothers)
+        {
+            s.frequency.reset (sampleRate, rampLengthSeconds);
+            s.q.reset (sampleRate, rampLengthSeconds);
+            s.gain.reset (sampleRate, rampLengthSeconds);
+        }
+
+        reset();
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::reset()
+    {
+        for (auto& g : groups)
+        {
+            std::fill (std::begin (g.s1), std::end (g.s1), Vec::expand (0));
+            std::fill (std::begin (g.s2), std::end (g.s2), Vec::expand (0));
+        }
+
+        // There is nothing to glide from after a reset
+        snapToNextSetup = true;
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::getState (std::vector<SampleType>& destination) const
+    {
+        // Group by group, s1 then s2 of each band, one value per lane
+        destination.resize (groups.size() * numBands * 2 * Vec::size());
+        auto* out = destination.data();
+
+        // The vector isn't aligned for the registers, so it goes through the lanes
+        alignas (sizeof (Vec)) SampleType lanes[Vec::SIMDNumElements] {};
+
+        for (const auto& g : groups)
+        {
+            for (size_t band = 0; band < (size_t) numBands; ++band)
+            {
+                for (const auto& s : { g.s1[band], g.s2[band] })
+                {
+                    s.copyToRawArray (lanes);
+                    out = std::copy (std::begin (lanes), std::end (lanes), out);
+                }
+            }
+        }
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::setState (const std::vector<SampleType>& source)
+    {
+        // A state from an engine prepared for a different channel count doesn't fit
+        jassert (source.size() == groups.size() * numBands * 2 * Vec::size());
+
+        if (source.size() != groups.size() * numBands * 2 * Vec::size())
+            return;
+
+        const auto* in = source.data();
+        alignas (sizeof (Vec)) SampleType lanes[Vec::SIMDNumElements] {};
+
+        const auto next = [&]
+        {
+            std::copy (in, in + Vec::size(), lanes);
+            in += Vec::size();
+            return Vec::fromRawArray (lanes);
+        };
+
+        for (auto& g : groups)
+        {
+            for (size_t band = 0; band < (size_t) numBands; ++band)
+            {
+                g.s1[band] = next();
+                g.s2[band] = next();
+            }
+        }
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::setCoefficients (int band, const BiquadCoefficients& newCoefficients)
+    {
+        jassert (isPositiveAndBelow (band, numBands));
+
+        cascade.b0[band] = (SampleType) newCoefficients.b0;
+        cascade.b1[band] = (SampleType) newCoefficients.b1;
+        cascade.b2[band] = (SampleType) newCoefficients.b2;
+        cascade.a1[band] = (SampleType) newCoefficients.a1;
+        cascade.a2[band] = (SampleType) newCoefficients.a2;
+    }
+
+    template <typename SampleType>
+    BiquadCoefficients EQEngine<SampleType>::getCoefficients (int band) const
+    {
+        jassert (isPositiveAndBelow (band, numBands));
+
+        BiquadCoefficients c;
+        c.b0 = cascade.b0[band];
+        c.b1 = cascade.b1[band];
+        c.b2 = cascade.b2[band];
+        c.a1 = cascade.a1[band];
+        c.a2 = cascade.a2[band];
+        return c;
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::setFilterSetup (const FilterSetup& newSetup)
+    {
+        // A new design method reshapes every band at once, so like a change of type it jumps
+        const auto methodChanged = newSetup.method != designMethod;
+        designMethod = newSetup.method;
+
+        for (size_t band = 0; band < (size_t) numBands; ++band)
+        {
+            const auto& p = newSetup.parameters[band];
+            auto& s = smoothers[band];
+
+            s.target = newSetup.coefficients[band];
+
+            // A change of type has no meaningful path between the two shapes, so it jumps
+            if (snapToNextSetup || methodChanged || smoothingBlockSize <= 0 || p.type != s.type)
+            {
+                s.frequency.setCurrentAndTargetValue (p.frequency);
+                s.q.setCurrentAndTargetValue (p.q);
+                s.gain.setCurrentAndTargetValue (p.gain);
+
+                setCoefficients ((int) band, s.target);
+            }
+            else
+            {
+                s.frequency.setTargetValue (p.frequency);
+                s.q.setTargetValue (p.q);
+                s.gain.setTargetValue (p.gain);
+            }
+
+            s.type = p.type;
+        }
+
+        bypassed = newSetup.bypassed;
+        snapToNextSetup = false;
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::setSmoothingBlockSize (int newSize)
+    {
+        smoothingBlockSize = jmax (0, newSize);
+
+        if (smoothingBlockSize == 0 && isSmoothing())
+        {
+            for (size_t band = 0; band < (size_t) numBands; ++band)
+            {
+                auto& s = smoothers[band];
+
+                s.frequency.setCurrentAndTargetValue (s.frequency.getTargetValue());
+                s.q.setCurrentAndTargetValue (s.q.getTargetValue());
+                s.gain.setCurrentAndTargetValue (s.gain.getTargetValue());
+
+                setCoefficients ((int) band, s.target);
+            }
+        }
+    }
+
+    template <typename SampleType>
+    bool EQEngine<SampleType>::isSmoothing() const
+    {
+        for (const auto& s : smoothers)
+            if (s.frequency.isSmoothing() || s.q.isSmoothing() || s.gain.isSmoothing())
+                return true;
+
+        return false;
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::advanceSmoothing (int numSamples)
+    {
+        for (size_t band = 0; band < (size_t) numBands; ++band)
+        {
+            auto& s = smoothers[band];
+
+            if (! (s.frequency.isSmoothing() || s.q.isSmoothing() || s.gain.isSmoothing()))
+                continue;
+
+            const auto frequency = s.frequency.skip (numSamples);
+            const auto q = s.q.skip (numSamples);
+            const auto gain = s.gain.skip (numSamples);
+
+            // Land exactly on the designed target once the ramp is over
+            if (s.frequency.isSmoothing() || s.q.isSmoothing() || s.gain.isSmoothing())
+            {
+                BiquadCoefficients c;
+                BiquadDesigner::design (s.type, designMethod, sampleRate, frequency, q, gain, c);
+                setCoefficients ((int) band, c);
+            }
+            else
+            {
+                setCoefficients ((int) band, s.target);
+            }
+        }
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::process (const dsp::AudioBlock<SampleType>& block)
+    {
+        const auto numSamples = block.getNumSamples();
+
+        runningInParallel = shouldRunInParallel();
+        const auto isTimed = multicoreRequested && workerPool != nullptr && groups.size() > 1;
+        const auto startTicks = isTimed ? Time::getHighResolutionTicks() : 0;
+
+        if (smoothingBlockSize <= 0 || ! isSmoothing())
+        {
+            processSubBlock (block);
+        }
+        else
+        {
+            for (size_t start = 0; start < numSamples;)
+            {
+                const auto length = jmin ((size_t) smoothingBlockSize, numSamples - start);
+
+                advanceSmoothing ((int) length);
+                processSubBlock (block.getSubBlock (start, length));
+
+                start += length;
+            }
+        }
+
+        if (isTimed)
+            recordBlockCost (runningInParallel, Time::getHighResolutionTicks() - startTicks, numSamples);
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::processSubBlock (const dsp::AudioBlock<SampleType>& block)
+    {
+        // Channels beyond what prepare() was told about have no state to run on
+        jassert (block.getNumChannels() <= groups.size() * Vec::size());
+
+        numActiveBands = 0;
+
+        for (size_t band = 0; band < (size_t) numBands; ++band)
+            if (! bypassed[band])
+                activeBands[numActiveBands++] = band;
+
+        if (numActiveBands == 0)
+            return;
+
+        const auto numChannels = jmin (block.getNumChannels(), groups.size() * Vec::size());
+        const auto numGroups = (numChannels + Vec::size() - 1) / Vec::size();
+
+        currentBlock = &block;
+
+        if (runningInParallel)
+        {
+            workerPool->run ((int) numGroups, processGroupJob, this);
+        }
+        else
+        {
+            for (size_t group = 0; group < numGroups; ++group)
+                processGroup (group);
+        }
+
+        currentBlock = nullptr;
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::processGroupJob (void* engine, int group)
+    {
+        static_cast<EQEngine*> (engine)->processGroup ((size_t) group);
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::processGroup (size_t group)
+    {
+        const auto& block = *currentBlock;
+        const auto first = group * Vec::size();
+        const auto numChannels = jmin (Vec::size(), block.getNumChannels() - first);
+        const auto numSamples = block.getNumSamples();
+        auto& state = groups[group];
+
+        SampleType* channels[Vec::SIMDNumElements] {};
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+            channels[ch] = block.getChannelPointer (first + ch);
+
+        // One instantiation per active band count, so the band loop is fully unrolled
+        switch (numActiveBands)
+        {
+            case 1: processCascade<1> (state, channels, numChannels, numSamples); break;
+            case 2: processCascade<2> (state, channels, numChannels, numSamples); break;
+            case 3: processCascade<3> (state, channels, numChannels, numSamples); break;
+            case 4: processCascade<4> (state, channels, numChannels, numSamples); break;
+            case 5: processCascade<5> (state, channels, numChannels, numSamples); break;
+            case 6: processCascade<6> (state, channels, numChannels, numSamples); break;
+            default: break;
+        }
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    void EQEngine<SampleType>::setWorkerPool (WorkerPool* newPool) noexcept
+    {
+        workerPool = newPool;
+        resetMulticoreTimings();
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::resetMulticoreTimings() noexcept
+    {
+        serialCost = 0.0;
+        parallelCost = 0.0;
+        blocksUntilProbe = blocksBetweenProbes;
+        multicoreStatus.store ((int) MulticoreStatus::off, std::memory_order_relaxed);
+    }
+
+    template <typename SampleType>
+    bool EQEngine<SampleType>::shouldRunInParallel() noexcept
+    {
+        if (! multicoreRequested || workerPool == nullptr || groups.size() < 2)
+        {
+            multicoreStatus.store ((int) MulticoreStatus::off, std::memory_order_relaxed);
+            return false;
+        }
+
+        // Each path is timed once before choosing, and the losing one is given another go
+        // now and then in case the machine's load has changed
+        if (serialCost <= 0.0)
+            return false;
+
+        if (parallelCost <= 0.0)
+            return true;
+
+        const auto parallelWins = parallelCost < serialCost;
+
+        if (--blocksUntilProbe <= 0)
+        {
+            blocksUntilProbe = blocksBetweenProbes;
+            return ! parallelWins;
+        }
+
+        return parallelWins;
+    }
+
+    template <typename SampleType>
+    void EQEngine<SampleType>::recordBlockCost (bool wasParallel, int64 ticks, size_t numSamples) noexcept
+    {
+        if (numSamples == 0)
+            return;
+
+        const auto cost = (double) ticks / (double) numSamples;
+        auto& average = wasParallel ? parallelCost : serialCost;
+
+        average = average <= 0.0 ? cost : average + 0.1 * (cost - average);
+
+        if (serialCost > 0.0 && parallelCost > 0.0)
+            multicoreStatus.store ((int) (parallelCost < serialCost ? MulticoreStatus::parallel
+                                                                    : MulticoreStatus::serialFallback),
+                                   std::memory_order_relaxed);
+    }
+
+    template <typename SampleType>
+    template <size_t numActive>
+    void EQEngine<SampleType>::processCascade (GroupState& state, SampleType* const* channels, size_t numChannels, size_t numSamples)
+    {
+        Vec b0[numActive], b1[numActive], b2[numActive], a1[numActive], a2[numActive];
+        Vec z1[numActive], z2[numActive];
+
+        for (size_t k = 0; k < numActive; ++k)
+        {
+            const auto band = activeBands[k];
+
+            b0[k] = Vec::expand (cascade.b0[band]);
+            b1[k] = Vec::expand (cascade.b1[band]);
+            b2[k] = Vec::expand (cascade.b2[band]);
+            a1[k] = Vec::expand (cascade.a1[band]);
+            a2[k] = Vec::expand (cascade.a2[band]);
+            z1[k] = state.s1[band];
+            z2[k] = state.s2[band];
+        }
+
+        alignas (sizeof (Vec)) SampleType lanes[Vec::SIMDNumElements] {};
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            for (size_t ch = 0; ch < numChannels; ++ch)
+                lanes[ch] = channels[ch][i];
+
+            auto x = Vec::fromRawArray (lanes);
+
+            for (size_t k = 0; k < numActive; ++k)
+            {
+                const auto y = b0[k] * x + z1[k];
+
+                z1[k] = b1[k] * x - a1[k] * y + z2[k];
+                z2[k] = b2[k] * x - a2[k] * y;
+
+                x = y;
+            }
+
+            x.copyToRawArray (lanes);
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+                channels[ch][i] = lanes[ch];
+        }
+
+        for (size_t k = 0; k < numActive; ++k)
+        {
+            state.s1[activeBands[k]] = z1[k];
+            state.s2[activeBands[k]] = z2[k];
+        }
+    }
+
+    //==============================================================================
+    template class EQEngine<float>;
+    template class EQEngine<double>;
+}
@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+    EQEngine.h
+    SIMD biquad cascade shared by every channel of the EQ.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "WorkerPool.h"
+
+namespace Dsp
+{
+    enum FilterType
+    {
+        lowCutType,
+        highCutType,
+        bellType,
+        notchType,
+        bandPassType
+    };
+
+    /** How a band's analog prototype is turned into a biquad. */
+    enum DesignMethod
+    {
+        bilinearDesign,     // RBJ cookbook; cramps towards nyquist
+        matchedDesign       // magnitude matched to the analog prototype up to nyquist
+    };
+
+    /** Normalised (a0 == 1) second order section. Kept in double so a double precision engine
+        gets every bit the designer produced; float engines round on the way in.
+    */
+    struct BiquadCoefficients
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+
+        double getMagnitudeForFrequency (double frequency, double sampleRate) const;
+
+        bool operator== (const BiquadCoefficients& other) const noexcept
+        {
+            return b0 == other.b0 && b1 == other.b1 && b2 == other.b2 && a1 == other.a1 && a2 == other.a2;
+        }
+
+        bool operator!= (const BiquadCoefficients& other) const noexcept   { return ! operator== (other); }
+    };
+
+    /** The user facing settings of one band; gain is a linear factor. */
+    struct BandParameters
+    {
+        FilterType type = bellType;
+        float frequency = 1000.0f, q = 0.707f, gain = 1.0f;
+    };
+
+    /** Everything the engine needs to know about its bands, handed to it in one piece. */
+    struct FilterSetup
+    {
+        static constexpr int numBands = 6;
+
+        std::array<BandParameters, numBands> parameters;
+        std::array<BiquadCoefficients, numBands> coefficients;
+        std::array<bool, numBands> bypassed {};
+        DesignMethod method = bilinearDesign;
+
+        // The rate the coefficients were designed for, which is the oversampled one when
+        // oversampling is on
+        double sampleRate = 44100.0;
+    };
+
+    enum class MulticoreStatus
+    {
+        off,
+        parallel,
+        serialFallback      // the workers cost more than they saved
+    };
+
+    //==============================================================================
+    /**
+        Six band biquad cascade that filters every channel of the bus in one pass.
+
+        Channels are packed, in order, into groups as wide as a SIMDRegister (for floats 4 lanes
+        with SSE or NEON and 8 with AVX, half that for doubles) and all groups share one set of
+        coefficients. Stereo fills half a float group, while a 5.1 or 7.1.4 bus costs only two or
+        three register passes. The per-group state is sized in prepare(), so processing never
+        allocates. Every sample is pushed through all active bands before the next one is
+        loaded, so the block is read and written once no matter how many bands are enabled,
+        and the coefficients and state of the active bands are held in registers for the
+        whole block.
+
+        The engine is instantiated for float and for double. Double keeps coefficients and
+        state in double all the way through, which is what low, narrow bells need to stay
+        free of noise and limit cycles.
+
+        When a new setup moves a band's frequency, Q or gain, the engine glides towards it
+        instead of jumping: the block is cut into sub-blocks and the band is redesigned from
+        the smoothed parameters at the start of each one. Frequency, Q and gain are smoothed
+        multiplicatively (i.e. in the log / dB domain), and every intermediate section is a
+        proper design rather than an interpolation of coefficients, so it is always stable.
+
+        With a WorkerPool attached and multicore enabled, the channel groups of each block are
+        shared out among the pool's workers and the calling thread. Both paths are timed as they
+        run, and whenever the parallel one turns out slower (typically because there are only a
+        couple of groups), the engine goes back to the calling thread and reports it through
+        getMulticoreStatus().
+    */
+    template <typename SampleType>
+    class EQEngine
+    {
+    public:
+        static constexpr int numBands = FilterSetup::numBands;
+
+        using Vec = dsp::SIMDRegister<SampleType>;
+
+        void prepare (const dsp::ProcessSpec& spec);
+        void reset();
+
+        void setCoefficients (int band, const BiquadCoefficients& newCoefficients);
+        BiquadCoefficients getCoefficients (int band) const;
+
+        void setBypassed (int band, bool shouldBeBypassed)          { bypassed[(size_t) band] = shouldBeBypassed; }
+        bool isBypassed (int band) const                            { return bypassed[(size_t) band]; }
+
+        /** Moves every band towards the given setup, ramping if smoothing is enabled. */
+        void setFilterSetup (const FilterSetup& newSetup);
+
+        /** The filter memory of every band and channel, as plain numbers. Saving and restoring it
+            lets an offline render be checkpointed and carried on elsewhere; restoring touches
+            neither the coefficients nor any ramp. Allocates, so not for the audio thread.
+        */
+        void getState (std::vector<SampleType>& destination) const;
+        void setState (const std::vector<SampleType>& source);
+
+        /** Number of samples between redesigns while a band is ramping; 0 makes changes jump. */
+        void setSmoothingBlockSize (int newSize);
+
+        void process (const dsp::AudioBlock<SampleType>& block);
+
+        /** Lets process() spread channel groups over the pool; nullptr keeps it on the calling thread. */
+        void setWorkerPool (WorkerPool* newPool) noexcept;
+        void setMulticoreEnabled (bool shouldUseWorkers) noexcept   { multicoreRequested = shouldUseWorkers; }
+
+        /** How the recent blocks were processed; safe to call from any thread. */
+        MulticoreStatus getMulticoreStatus() const noexcept
+        {
+            return (MulticoreStatus) multicoreStatus.load (std::memory_order_relaxed);
+        }
+
+    private:
+        bool isSmoothing() const;
+        void advanceSmoothing (int numSamples);
+
+        /** Transposed direct form II state of one group of channels, one lane per channel. */
+        struct alignas (64) GroupState
+        {
+            Vec s1[numBands], s2[numBands];
+        };
+
+        void processSubBlock (const dsp::AudioBlock<SampleType>& block);
+        void processGroup (size_t group);
+        static void processGroupJob (void* engine, int group);
+
+        bool shouldRunInParallel() noexcept;
+        void recordBlockCost (bool wasParallel, int64 ticks, size_t numSamples) noexcept;
+        void resetMulticoreTimings() noexcept;
+
+        template <size_t numActive>
+        void processCascade (GroupState& state, SampleType* const* channels, size_t numChannels, size_t numSamples);
+
+        /** Structure-of-arrays coefficient block shared by all channel groups, kept on its own
+            cache lines so an instance costs a handful of lines rather than a heap object per band.
+        */
+        struct alignas (64) Cascade
+        {
+            SampleType b0[numBands] { 1, 1, 1, 1, 1, 1 };
+            SampleType b1[numBands] {}, b2[numBands] {}, a1[numBands] {}, a2[numBands] {};
+        };
+
+        struct BandSmoother
+        {
+            FilterType type = bellType;
+            SmoothedValue<float, ValueSmoothingTypes::Multiplicative> frequency { 1000.0f }, q { 0.707f }, gain { 1.0f };
+            BiquadCoefficients target;
+        };
+
+        static constexpr double rampLengthSeconds = 0.05;
+        static constexpr int blocksBetweenProbes = 256;
+
+        Cascade cascade;
+        std::vector<GroupState> groups;
+        std::array<bool, numBands> bypassed {};
+
+        std::array<BandSmoother, numBands> smoothers;
+        DesignMethod designMethod = bilinearDesign;
+        double sampleRate = 44100.0;
+        int smoothingBlockSize = 32;
+        bool snapToNextSetup = true;
+
+        // What processSubBlock hands to the groups, whichever thread ends up running them
+        const dsp::AudioBlock<SampleType>* currentBlock = nullptr;
+        std::array<size_t, numBands> activeBands {};
+        size_t numActiveBands = 0;
+
+        WorkerPool* workerPool = nullptr;
+        bool multicoreRequested = false, runningInParallel = false;
+
+        // Smoothed cost of each path in ticks per sample; 0 until it has been timed
+        double serialCost = 0.0, parallelCost = 0.0;
+        int blocksUntilProbe = blocksBetweenProbes;
+        std::atomic<int> multicoreStatus { (int) MulticoreStatus::off };
+    };
+}
@@ -0,0 +1,245 @@
+/*
+  ==============================================================================
+
+    LinearPhaseEQ.cpp
+    Linear phase rendition of the band cascade as one symmetric FIR kernel.
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseEQ.h"
+#include "TripleBuffer.h"
+#include "Semaphore.h"
+
+namespace Dsp
+{
+    /** One enable()'s worth: the convolvers, their message queue and the kernel thread. */
+    class LinearPhaseEQ::Renderer  : private Thread
+    {
+    public:
+        Renderer (const dsp::ProcessSpec& spec, int qualityToUse, const FilterSetup& setup)
+            : Thread ("EQ linear phase kernels"),
+              quality (qualityToUse),
+              sampleRate (spec.sampleRate),
+              builtSetup (setup)
+        {
+            // dsp::Convolution handles at most a stereo pair
+            const auto numPairs = jmax ((uint32) 1, (spec.numChannels + 1) / 2);
+
+            for (uint32 pair = 0; pair < numPairs; ++pair)
+                convolvers.push_back (std::make_unique<dsp::Convolution> (dsp::Convolution::Latency { partitionSize }, queue));
+
+            // Loaded before prepare(), the kernel is installed right there instead of being
+            // crossfaded in later from the queue's thread
+            loadKernel (setup);
+
+            for (uint32 pair = 0; pair < numPairs; ++pair)
+                convolvers[pair]->prepare ({ spec.sampleRate, spec.maximumBlockSize,
+                                             jmax ((uint32) 1, jmin ((uint32) 2, spec.numChannels - pair * 2)) });
+
+            latencySamples = getKernelLength (quality, sampleRate) / 2 + convolvers.front()->getLatency();
+
+            startThread (Thread::Priority::low);
+        }
+
+        ~Renderer() override
+        {
+            signalThreadShouldExit();
+            wakeUp.post();
+            stopThread (2000);
+        }
+
+        int getQuality() const noexcept                 { return quality; }
+        int getLatencySamples() const noexcept          { return latencySamples; }
+
+        /** True if the setup filters like the one the first kernel was designed from. */
+        bool isBuiltFor (const FilterSetup& setup) const noexcept
+        {
+            return setup.coefficients == builtSetup.coefficients
+                    && setup.bypassed == builtSetup.bypassed
+                    && setup.sampleRate == builtSetup.sampleRate;
+        }
+
+        // Audio thread: the post takes no lock and only enters the kernel if the thread sleeps
+        void setFilterSetup (const FilterSetup& newSetup) noexcept
+        {
+            setupExchange.getWriteBuffer() = newSetup;
+            setupExchange.publish();
+            wakeUp.post();
+        }
+
+        void reset()
+        {
+            for (auto& convolver : convolvers)
+                convolver->reset();
+        }
+
+        void process (const dsp::AudioBlock<float>& block)
+        {
+            const auto numChannels = block.getNumChannels();
+
+            for (size_t pair = 0; pair < convolvers.size() && pair * 2 < numChannels; ++pair)
+            {
+                auto pairBlock = block.getSubsetChannelBlock (pair * 2, jmin ((size_t) 2, numChannels - pair * 2));
+                convolvers[pair]->process (dsp::ProcessContextReplacing<float> (pairBlock));
+            }
+        }
+
+    private:
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                // Asleep until the audio thread hands over a setup; posts that find nothing
+                // new were for a setup already built
+                wakeUp.wait();
+
+                if (setupExchange.pull())
+                    loadKernel (setupExchange.getReadBuffer());
+            }
+        }
+
+        void loadKernel (const FilterSetup& setup)
+        {
+            AudioBuffer<float> kernel (1, getKernelLength (quality, sampleRate));
+            designKernel (setup, sampleRate, kernel);
+
+            for (auto& convolver : convolvers)
+            {
+                AudioBuffer<float> copy (kernel);
+                convolver->loadImpulseResponse (std::move (copy), sampleRate,
+                                                dsp::Convolution::Stereo::no,
+                                                dsp::Convolution::Trim::no,
+                                                dsp::Convolution::Normalise::no);
+            }
+        }
+
+        // Outlives the convolvers that post to it
+        dsp::ConvolutionMessageQueue queue;
+        std::vector<std::unique_ptr<dsp::Convolution>> convolvers;
+
+        const int quality;
+        const double sampleRate;
+        const FilterSetup builtSetup;
+        int latencySamples = 0;
+
+        // Audio thread -> kernel thread
+        TripleBuffer<FilterSetup> setupExchange;
+        Semaphore wakeUp;
+    };
+
+    //==============================================================================
+    LinearPhaseEQ::LinearPhaseEQ() = default;
+    LinearPhaseEQ::~LinearPhaseEQ() = default;
+
+    void LinearPhaseEQ::prepare (const dsp::ProcessSpec& newSpec)
+    {
+        renderers.clear();
+        spec = newSpec;
+    }
+
+    void LinearPhaseEQ::release()
+    {
+        renderers.clear();
+    }
+
+    void LinearPhaseEQ::enable (int quality, const FilterSetup& setup)
+    {
+        auto renderer = std::make_unique<Renderer> (spec, jlimit ((int) low, (int) high, quality), setup);
+        latencySamples.store (renderer->getLatencySamples());
+        renderers.set (std::move (renderer));
+    }
+
+    void LinearPhaseEQ::disable()
+    {
+        if (renderers.get() != nullptr)
+            renderers.set (nullptr);
+    }
+
+    int LinearPhaseEQ::getEnabledQuality() const noexcept
+    {
+        const auto* renderer = renderers.get();
+        return renderer != nullptr ? renderer->getQuality() : -1;
+    }
+
+    void LinearPhaseEQ::collectGarbage()
+    {
+        renderers.collectGarbage();
+    }
+
+    bool LinearPhaseEQ::beginBlock (const FilterSetup& currentSetup) noexcept
+    {
+        // Only a setup that has moved on is worth a second kernel; an offline render that starts
+        // straight after prepare then runs on the first kernel alone, with no crossfade racing it
+        if (renderers.acquire())
+            if (auto* renderer = renderers.getAcquired())
+                if (! renderer->isBuiltFor (currentSetup))
+                    renderer->setFilterSetup (currentSetup);
+
+        return renderers.getAcquired() != nullptr;
+    }
+
+    void LinearPhaseEQ::setFilterSetup (const FilterSetup& newSetup) noexcept
+    {
+        if (auto* renderer = renderers.getAcquired())
+            renderer->setFilterSetup (newSetup);
+    }
+
+    void LinearPhaseEQ::reset()
+    {
+        if (auto* renderer = renderers.getAcquired())
+            renderer->reset();
+    }
+
+    void LinearPhaseEQ::process (const dsp::AudioBlock<float>& block)
+    {
+        if (auto* renderer = renderers.getAcquired())
+            renderer->process (block);
+    }
+
+    int LinearPhaseEQ::getKernelLength (int quality, double sampleRate) noexcept
+    {
+        static constexpr int lengthsAt48k[] { 2048, 8192, 32768 };
+
+        const auto rateFactor = jmax (1, nextPowerOfTwo (roundToInt (sampleRate / 48000.0)));
+        return lengthsAt48k[jlimit (0, (int) std::size (lengthsAt48k) - 1, quality)] * rateFactor;
+    }
+
+    void LinearPhaseEQ::designKernel (const FilterSetup& setup, double sampleRate, AudioBuffer<float>& kernel)
+    {
+        const auto length = kernel.getNumSamples();
+        const auto order = roundToInt (std::log2 ((double) length));
+        jassert ((1 << order) == length);
+
+        // Zero phase spectrum: just the product of the active bands' magnitudes. They are read
+        // at the rate they were designed for, so an oversampled design keeps its uncramped shape
+        std::vector<float> spectrum ((size_t) length * 2, 0.0f);
+
+        for (int bin = 0; bin <= length / 2; ++bin)
+        {
+            const auto frequency = (double) bin * sampleRate / (double) length;
+            auto magnitude = 1.0;
+
+            for (size_t band = 0; band < (size_t) FilterSetup::numBands; ++band)
+                if (! setup.bypassed[band])
+                    magnitude *= setup.coefficients[band].getMagnitudeForFrequency (frequency, setup.sampleRate);
+
+            spectrum[(size_t) bin * 2] = (float) magnitude;
+        }
+
+        dsp::FFT fft (order);
+        fft.performRealOnlyInverseTransform (spectrum.data());
+
+        // Rotate the impulse to the middle and taper it; the window spans samples 1 .. length - 1
+        // so the kernel is exactly symmetric about length / 2
+        std::vector<float> window ((size_t) length - 1);
+        dsp::WindowingFunction<float>::fillWindowingTables (window.data(), window.size(),
+                                                            dsp::WindowingFunction<float>::blackmanHarris, false);
+
+        auto* h = kernel.getWritePointer (0);
+        h[0] = 0.0f;
+
+        for (int n = 1; n < length; ++n)
+            h[n] = spectrum[(size_t) ((n - length / 2 + length) % length)] * window[(size_t) n - 1];
+    }
+}
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    LinearPhaseEQ.h
+    Linear phase rendition of the band cascade as one symmetric FIR kernel.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "EQEngine.h"
+#include "ObjectHandoff.h"
+
+namespace Dsp
+{
+    /**
+        Applies the combined magnitude response of a FilterSetup with zero phase distortion.
+
+        Nothing is built while the mode is off. enable() creates one uniformly partitioned
+        dsp::Convolution per channel pair with a first kernel already installed, plus a thread
+        that keeps the kernel up to date, and disable() drops all of it again. Both run on the
+        message thread; the audio thread takes the change over at the start of its next block.
+
+        Every new FilterSetup the audio thread hands over wakes the kernel thread. It samples
+        the magnitude of the active bands on an FFT grid, turns it into a windowed, symmetric
+        kernel centred on half its length and loads it into the convolvers, which build it off
+        the audio thread and crossfade to it, so changes never block or click.
+
+        The quality picks the kernel length and therefore the trade between latency and low
+        frequency resolution; lengths scale with the sample rate so the resolution in Hz stays
+        the same at 96 or 192 kHz.
+    */
+    class LinearPhaseEQ
+    {
+    public:
+        enum Quality
+        {
+            low,
+            medium,
+            high
+        };
+
+        LinearPhaseEQ();
+        ~LinearPhaseEQ();
+
+        /** Message thread, while nothing is processing: the format to build for. Drops
+            anything built for the previous one.
+        */
+        void prepare (const dsp::ProcessSpec& spec);
+
+        /** Message thread, while nothing is processing: drops everything straight away. */
+        void release();
+
+        /** Message thread: builds convolvers of the given quality with the kernel for the setup
+            installed, so the first block they see is already filtered. Replaces any built before.
+        */
+        void enable (int quality, const FilterSetup& setup);
+
+        /** Message thread: drops the convolvers and the kernel thread. */
+        void disable();
+
+        /** Message thread: the quality built by the last enable(), or -1 while disabled. */
+        int getEnabledQuality() const noexcept;
+
+        /** Message thread: frees what the audio thread has let go of; call now and then. */
+        void collectGarbage();
+
+        /** Audio thread, before each block: takes over what the message thread built or
+            dropped. A newly built set is handed the current setup, which may have moved on
+            since it was built.
+            @returns true if process() will filter.
+        */
+        bool beginBlock (const FilterSetup& currentSetup) noexcept;
+
+        /** Audio thread: new settings for the kernel thread. */
+        void setFilterSetup (const FilterSetup& newSetup) noexcept;
+
+        void reset();
+        void process (const dsp::AudioBlock<float>& block);
+
+        /** Delay of the kernel enabled last, including the convolver's own. */
+        int getLatencySamples() const noexcept                  { return latencySamples.load(); }
+
+        static int getKernelLength (int quality, double sampleRate) noexcept;
+
+        /** Designs the kernel for the given bands; any thread, allocates. */
+        static void designKernel (const FilterSetup& setup, double sampleRate, AudioBuffer<float>& kernel);
+
+    private:
+        class Renderer;
+
+        static constexpr int partitionSize = 512;
+
+        dsp::ProcessSpec spec { 44100.0, 512, 2 };
+        ObjectHandoff<Renderer> renderers;
+        std::atomic<int> latencySamples { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE (LinearPhaseEQ)
+    };
+}
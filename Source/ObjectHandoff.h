@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    ObjectHandoff.h
+    Hands heap objects built on the message thread to the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp
+{
+    /**
+        Lets the message thread build, swap and drop an object the audio thread works with,
+        without the audio thread ever allocating, freeing or waiting for it.
+
+        The message thread set()s a new object, or nullptr for none, and the audio thread
+        acquire()s whatever was set last at the start of each block and keeps using it until
+        its next acquire(). Each set() is a numbered request that acquire() acknowledges, and
+        an object that set() replaced is only deleted once a request at least as new has been
+        acknowledged, i.e. once the audio thread can no longer be using it. That happens in
+        the next set() or collectGarbage(), so a message thread timer should call the latter.
+
+        One message thread and one audio thread at a time.
+    */
+    template <typename Type>
+    class ObjectHandoff
+    {
+    public:
+        ObjectHandoff() = default;
+
+        /** Message thread: the object the audio thread is to use from its next block on. */
+        void set (std::unique_ptr<Type> newObject)
+        {
+            collectGarbage();
+
+            // The object before the request number, so a reader that sees the number sees it too
+            const auto request = latestRequest.load (std::memory_order_relaxed) + 1;
+            pending.store (newObject.get(), std::memory_order_release);
+            latestRequest.store (request, std::memory_order_release);
+
+            if (current != nullptr)
+                retired.push_back ({ std::move (current), request });
+
+            current = std::move (newObject);
+        }
+
+        /** Message thread: the object set last, which the audio thread may not have yet. */
+        Type* get() const noexcept                          { return current.get(); }
+
+        /** Message thread: deletes the replaced objects the audio thread has let go of. */
+        void collectGarbage()
+        {
+            const auto acknowledged = acknowledgedRequest.load (std::memory_order_acquire);
+
+            retired.erase (std::remove_if (retired.begin(), retired.end(),
+                                           [acknowledged] (const Retired& r) { return (int) (acknowledged - r.request) >= 0; }),
+                           retired.end());
+        }
+
+        /** Only while the audio thread isn't running: deletes everything, the current object too. */
+        void clear()
+        {
+            pending.store (nullptr);
+            acknowledgedRequest.store (latestRequest.load());
+            acquired = nullptr;
+            retired.clear();
+            current.reset();
+        }
+
+        /** Audio thread: takes over the object set last.
+            @returns true if getAcquired() changed.
+        */
+        bool acquire() noexcept
+        {
+            const auto request = latestRequest.load (std::memory_order_acquire);
+
+            if (request == acknowledgedRequest.load (std::memory_order_relaxed))
+                return false;
+
+            acquired = pending.load (std::memory_order_acquire);
+            acknowledgedRequest.store (request, std::memory_order_release);
+            return true;
+        }
+
+        /** Audio thread: the object taken by the last acquire(), or nullptr. */
+        Type* getAcquired() const noexcept                  { return acquired; }
+
+    private:
+        struct Retired
+        {
+            std::unique_ptr<Type> object;
+            uint32 request;
+        };
+
+        std::unique_ptr<Type> current;
+        std::vector<Retired> retired;
+
+        std::atomic<Type*> pending { nullptr };
+        std::atomic<uint32> latestRequest { 0 }, acknowledgedRequest { 0 };
+
+        // Audio thread
+        Type* acquired = nullptr;
+
+        JUCE_DECLARE_NON_COPYABLE (ObjectHandoff)
+    };
+}
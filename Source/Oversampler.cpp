@@ -0,0 +1,315 @@
+/*
+  ==============================================================================
+
+    Oversampler.cpp
+    SIMD polyphase IIR half-band up and down sampling around the cascade.
+
+  ==============================================================================
+*/
+
+#include "Oversampler.h"
+
+namespace Dsp
+{
+    namespace
+    {
+        /*  Allpass coefficients of the half-band stages, from the elliptic design of Valenzuela
+            and Constantinides. Even indices make up the first chain, odd ones the second:
+            H(z) = (A0(z^2) + z^-1 A1(z^2)) / 2
+        */
+
+        // 8 coefficients, transition 0.04: flat to 0.46 of the stage's Nyquist, -99 dB beyond 0.54
+        constexpr double steepStage[] { 0.04063346092419326, 0.15050512902267460, 0.30075705599187410, 0.46077450496145060,
+                                        0.60952431489618830, 0.73850384111885730, 0.84922381039206610, 0.94974278370500020 };
+
+        // 4 coefficients, transition 0.2: -100 dB beyond 0.7, enough above a signal already cut at 0.46 / 2
+        constexpr double wideStage[] { 0.04955103531301993, 0.19357032634740400, 0.42673668875647364, 0.76707007281308140 };
+
+        constexpr int getNumCoefficients (int stage) noexcept
+        {
+            return stage == 0 ? (int) std::size (steepStage) : (int) std::size (wideStage);
+        }
+
+        constexpr double getCoefficient (int stage, int index) noexcept
+        {
+            return stage == 0 ? steepStage[index] : wideStage[index];
+        }
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    void Oversampler<SampleType>::prepare (size_t newNumChannels, size_t maximumBlockSize)
+    {
+        numChannels = newNumChannels;
+
+        // Enough for a whole block at 2x; 4x and 8x take it in two or four pieces
+        capacity = jmax ((size_t) 2, maximumBlockSize * 2);
+
+        groups.resize ((numChannels + Vec::size() - 1) / Vec::size());
+        scratch[0].assign (capacity, Vec::expand (0));
+        scratch[1].assign (capacity, Vec::expand (0));
+        oversampled.setSize ((int) jmax ((size_t) 1, numChannels), (int) capacity);
+
+        for (int stage = 0; stage < maxFactorLog2; ++stage)
+            for (int i = 0; i < getNumCoefficients (stage); ++i)
+                coefficients[stage][i] = Vec::expand ((SampleType) getCoefficient (stage, i));
+
+        reset();
+    }
+
+    template <typename SampleType>
+    void Oversampler<SampleType>::reset() noexcept
+    {
+        const auto zero = Vec::expand (0);
+
+        for (auto& g : groups)
+        {
+            for (auto& stage : g.stages)
+            {
+                for (auto* state : { &stage.up, &stage.down })
+                {
+                    std::fill (std::begin (state->x1), std::end (state->x1), zero);
+                    std::fill (std::begin (state->y1), std::end (state->y1), zero);
+                }
+
+                stage.previousOdd = zero;
+            }
+        }
+    }
+
+    template <typename SampleType>
+    void Oversampler<SampleType>::setFactorLog2 (int newFactorLog2) noexcept
+    {
+        newFactorLog2 = jlimit (0, maxFactorLog2, newFactorLog2);
+
+        if (newFactorLog2 != factorLog2)
+        {
+            factorLog2 = newFactorLog2;
+            reset();
+        }
+    }
+
+    template <typename SampleType>
+    double Oversampler<SampleType>::getLatency (int factor) noexcept
+    {
+        auto latency = 0.0;
+
+        for (int stage = 0; stage < jlimit (0, maxFactorLog2, factor); ++stage)
+        {
+            // A first order allpass in z^2 delays low frequencies by 2 (1 - a) / (1 + a) samples
+            // at the stage's upper rate, and the second chain has its extra sample on top
+            double chainDelays[2] { 0.0, 1.0 };
+
+            for (int i = 0; i < getNumCoefficients (stage); ++i)
+            {
+                const auto a = getCoefficient (stage, i);
+                chainDelays[i % 2] += 2.0 * (1.0 - a) / (1.0 + a);
+            }
+
+            // Near DC both chains are in phase, so the half-band delays by their mean. Up and
+            // down each add that, and one sample here is 2^(stage + 1) times shorter than at the host
+            latency += (chainDelays[0] + chainDelays[1]) / (double) (1 << (stage + 1));
+        }
+
+        return latency;
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    dsp::AudioBlock<SampleType> Oversampler<SampleType>::processSamplesUp (const dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        jassert (factorLog2 > 0);
+        jassert (block.getNumSamples() <= getMaxHostSamples());
+        jassert (block.getNumChannels() <= numChannels);
+
+        const auto channelsUsed = jmin (block.getNumChannels(), numChannels);
+        numOversampled = jmin (block.getNumSamples(), getMaxHostSamples()) << factorLog2;
+
+        for (size_t group = 0; group * Vec::size() < channelsUsed; ++group)
+            upsampleGroup (group, block);
+
+        return dsp::AudioBlock<SampleType> (oversampled).getSubsetChannelBlock (0, channelsUsed)
+                                                         .getSubBlock (0, numOversampled);
+    }
+
+    template <typename SampleType>
+    void Oversampler<SampleType>::processSamplesDown (const dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        jassert (block.getNumSamples() << factorLog2 == numOversampled);
+
+        const auto channelsUsed = jmin (block.getNumChannels(), numChannels);
+
+        for (size_t group = 0; group * Vec::size() < channelsUsed; ++group)
+            downsampleGroup (group, block);
+    }
+
+    template <typename SampleType>
+    void Oversampler<SampleType>::upsampleGroup (size_t group, const dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto first = group * Vec::size();
+        const auto numGroupChannels = jmin (Vec::size(), jmin (block.getNumChannels(), numChannels) - first);
+        auto numSamples = numOversampled >> factorLog2;
+
+        const SampleType* source[Vec::SIMDNumElements] {};
+        SampleType* destination[Vec::SIMDNumElements] {};
+
+        for (size_t ch = 0; ch < numGroupChannels; ++ch)
+        {
+            source[ch] = block.getChannelPointer (first + ch);
+            destination[ch] = oversampled.getWritePointer ((int) (first + ch));
+        }
+
+        alignas (sizeof (Vec)) SampleType lanes[Vec::SIMDNumElements] {};
+        auto* in = scratch[0].data();
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            for (size_t ch = 0; ch < numGroupChannels; ++ch)
+                lanes[ch] = source[ch][i];
+
+            in[i] = Vec::fromRawArray (lanes);
+        }
+
+        auto* out = scratch[1].data();
+
+        for (int stage = 0; stage < factorLog2; ++stage)
+        {
+            auto& state = groups[group].stages[stage].up;
+
+            if (stage == 0)
+                upsampleStage<(int) std::size (steepStage)> (coefficients[stage], state, in, out, numSamples);
+            else
+                upsampleStage<(int) std::size (wideStage)> (coefficients[stage], state, in, out, numSamples);
+
+            numSamples *= 2;
+            std::swap (in, out);
+        }
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            in[i].copyToRawArray (lanes);
+
+            for (size_t ch = 0; ch < numGroupChannels; ++ch)
+                destination[ch][i] = lanes[ch];
+        }
+    }
+
+    template <typename SampleType>
+    void Oversampler<SampleType>::downsampleGroup (size_t group, const dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto first = group * Vec::size();
+        const auto numGroupChannels = jmin (Vec::size(), jmin (block.getNumChannels(), numChannels) - first);
+        auto numSamples = numOversampled;
+
+        const SampleType* source[Vec::SIMDNumElements] {};
+        SampleType* destination[Vec::SIMDNumElements] {};
+
+        for (size_t ch = 0; ch < numGroupChannels; ++ch)
+        {
+            source[ch] = oversampled.getReadPointer ((int) (first + ch));
+            destination[ch] = block.getChannelPointer (first + ch);
+        }
+
+        alignas (sizeof (Vec)) SampleType lanes[Vec::SIMDNumElements] {};
+        auto* data = scratch[0].data();
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            for (size_t ch = 0; ch < numGroupChannels; ++ch)
+                lanes[ch] = source[ch][i];
+
+            data[i] = Vec::fromRawArray (lanes);
+        }
+
+        // Back down in the opposite order, so the steep stage is again the one at the host rate
+        for (int stage = factorLog2; --stage >= 0;)
+        {
+            numSamples /= 2;
+            auto& state = groups[group].stages[stage];
+
+            if (stage == 0)
+                downsampleStage<(int) std::size (steepStage)> (coefficients[stage], state, data, numSamples);
+            else
+                downsampleStage<(int) std::size (wideStage)> (coefficients[stage], state, data, numSamples);
+        }
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            data[i].copyToRawArray (lanes);
+
+            for (size_t ch = 0; ch < numGroupChannels; ++ch)
+                destination[ch][i] = lanes[ch];
+        }
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    template <int numCoefficients>
+    void Oversampler<SampleType>::upsampleStage (const Vec* a, AllpassState& state, const Vec* in, Vec* out, size_t numIn) noexcept
+    {
+        Vec x1[numCoefficients], y1[numCoefficients];
+        std::copy (state.x1, state.x1 + numCoefficients, x1);
+        std::copy (state.y1, state.y1 + numCoefficients, y1);
+
+        // Both chains see every input sample, and each writes every other output sample
+        for (size_t i = 0; i < numIn; ++i)
+        {
+            Vec chains[2] { in[i], in[i] };
+
+            for (int k = 0; k < numCoefficients; ++k)
+            {
+                auto& x = chains[k % 2];
+                const auto y = a[k] * (x - y1[k]) + x1[k];
+
+                x1[k] = x;
+                y1[k] = y;
+                x = y;
+            }
+
+            out[2 * i] = chains[0];
+            out[2 * i + 1] = chains[1];
+        }
+
+        std::copy (x1, x1 + numCoefficients, state.x1);
+        std::copy (y1, y1 + numCoefficients, state.y1);
+    }
+
+    template <typename SampleType>
+    template <int numCoefficients>
+    void Oversampler<SampleType>::downsampleStage (const Vec* a, StageState& state, Vec* data, size_t numOut) noexcept
+    {
+        Vec x1[numCoefficients], y1[numCoefficients];
+        std::copy (state.down.x1, state.down.x1 + numCoefficients, x1);
+        std::copy (state.down.y1, state.down.y1 + numCoefficients, y1);
+
+        auto previousOdd = state.previousOdd;
+        const auto half = Vec::expand ((SampleType) 0.5);
+
+        // In place: output i is written after inputs 2i and 2i + 1 have been read
+        for (size_t i = 0; i < numOut; ++i)
+        {
+            Vec chains[2] { data[2 * i], previousOdd };
+            previousOdd = data[2 * i + 1];
+
+            for (int k = 0; k < numCoefficients; ++k)
+            {
+                auto& x = chains[k % 2];
+                const auto y = a[k] * (x - y1[k]) + x1[k];
+
+                x1[k] = x;
+                y1[k] = y;
+                x = y;
+            }
+
+            data[i] = (chains[0] + chains[1]) * half;
+        }
+
+        state.previousOdd = previousOdd;
+        std::copy (x1, x1 + numCoefficients, state.down.x1);
+        std::copy (y1, y1 + numCoefficients, state.down.y1);
+    }
+
+    //==============================================================================
+    template class Oversampler<float>;
+    template class Oversampler<double>;
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    Oversampler.h
+    SIMD polyphase IIR half-band up and down sampling around the cascade.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp
+{
+    /**
+        2x, 4x or 8x oversampling made of cascaded polyphase IIR half-band stages.
+
+        Each stage splits its half-band lowpass into two chains of first order allpass sections
+        running at the lower of its two rates, so doubling the rate costs one allpass per
+        coefficient and sample. The stage next to the host rate is the steep one, with its
+        passband up to 0.46 of its Nyquist and 99 dB of rejection; the stages above it only
+        have to clear the images of an already band limited signal, so they make do with
+        half the coefficients at the same rejection.
+
+        Like the EQEngine, channels are packed into groups as wide as a SIMDRegister and a
+        group goes through all stages with one lane per channel, so a stereo or surround bus
+        costs one or two register passes per stage.
+
+        The buffers are sized in prepare() for twice the host block, whatever the factor, so
+        switching factors never allocates. A block that would not fit at the chosen factor has
+        to be handed over in pieces of at most getMaxHostSamples().
+
+        The phase response is minimum phase like the cascade's; getLatency() is its group
+        delay at low frequencies, which is what the host is told to compensate.
+    */
+    template <typename SampleType>
+    class Oversampler
+    {
+    public:
+        static constexpr int maxFactorLog2 = 3;
+
+        using Vec = dsp::SIMDRegister<SampleType>;
+
+        /** Message thread: allocates for the channel count and the host's block size. */
+        void prepare (size_t numChannels, size_t maximumBlockSize);
+        void reset() noexcept;
+
+        /** 0 for none up to maxFactorLog2; resets the stages if the factor changes. */
+        void setFactorLog2 (int newFactorLog2) noexcept;
+        int getFactorLog2() const noexcept                     { return factorLog2; }
+
+        /** The longest block processSamplesUp() takes at the current factor. */
+        size_t getMaxHostSamples() const noexcept               { return capacity >> factorLog2; }
+
+        /** Delay at the host rate, in samples, of the way up and down at the given factor. */
+        static double getLatency (int factorLog2) noexcept;
+
+        /** Brings the block up to the oversampled rate in the internal buffer and returns that. */
+        dsp::AudioBlock<SampleType> processSamplesUp (const dsp::AudioBlock<SampleType>& block) noexcept;
+
+        /** Brings the internal buffer back down into the block that went up last. */
+        void processSamplesDown (const dsp::AudioBlock<SampleType>& block) noexcept;
+
+    private:
+        static constexpr int maxCoefficients = 8;
+
+        /** One direction of one stage: the previous input and output of each allpass. */
+        struct AllpassState
+        {
+            Vec x1[maxCoefficients], y1[maxCoefficients];
+        };
+
+        struct StageState
+        {
+            AllpassState up, down;
+            Vec previousOdd;    // the downsampler's second chain runs a sample behind
+        };
+
+        struct alignas (64) GroupState
+        {
+            StageState stages[maxFactorLog2];
+        };
+
+        template <int numCoefficients>
+        static void upsampleStage (const Vec* a, AllpassState& state, const Vec* in, Vec* out, size_t numIn) noexcept;
+
+        template <int numCoefficients>
+        static void downsampleStage (const Vec* a, StageState& state, Vec* data, size_t numOut) noexcept;
+
+        void upsampleGroup (size_t group, const dsp::AudioBlock<SampleType>& block) noexcept;
+        void downsampleGroup (size_t group, const dsp::AudioBlock<SampleType>& block) noexcept;
+
+        // Per stage, expanded to every lane; the first stage uses all, the others half
+        Vec coefficients[maxFactorLog2][maxCoefficients];
+
+        std::vector<GroupState> groups;
+        std::vector<Vec> scratch[2];
+        AudioBuffer<SampleType> oversampled;
+        size_t numChannels = 0, capacity = 0, numOversampled = 0;
+        int factorLog2 = 0;
+    };
+}
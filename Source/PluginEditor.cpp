@@ -13,53 +13,185 @@
 ResponseCurveComponent::ResponseCurveComponent (SimpleEQAudioProcessor& p)
 : audioProcessor (p)
 {
-    const auto& params = audioProcessor.getParameters();
-    for( auto param : params )
-    {
-        param->addListener(this);
-    }
-    
-    startTimerHz (60);
+    // The static layer covers every pixel, so repaints never reach the editor behind
+    setOpaque (true);
 }
 
 ResponseCurveComponent::~ResponseCurveComponent()
 {
-    const auto& params = audioProcessor.getParameters();
-    for( auto param : params )
-    {
-        param->removeListener(this);
-    }
 }
 
 void ResponseCurveComponent::paint(juce::Graphics& g)
 {
-    drawBackgroundGrid (g);
-    drawTextLabels (g);
-
-    g.setColour(Colours::orange);
-    g.strokePath(responseCurve, PathStrokeType(2.f));
+    // Only the curve and the analyzer change between frames; the rest is blitted
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    
+    if (staticLayer.isNull()
+        || scale != staticLayerScale
+        || staticLayer.getWidth() != roundToInt ((float) getWidth() * scale)
+        || staticLayer.getHeight() != roundToInt ((float) getHeight() * scale))
+        renderStaticLayer (scale);
+    
+    g.drawImage (staticLayer, getLocalBounds().toFloat());
+    
+    // The curve and the analyzer come pre-rendered; until a frame for a new size arrives
+    // the previous one is stretched over it
+    const auto& frame = curveRenderer.getFrame();
+    
+    if (frame.image.isValid())
+        g.drawImage (frame.image, getLocalBounds().toFloat());
+    
+    if (scale != paintScale)
+    {
+        paintScale = scale;
+        submitLayers (getLocalBounds().toFloat());
+    }
 }
 
 void ResponseCurveComponent::resized()
 {
     responseCurve.preallocateSpace(getWidth() * 3);
+    audioProcessor.getLatestFilterSetup (filterSetup);
     updateResponseCurve();
+    updateSpectrumCurves();
+    submitLayers (getLocalBounds().toFloat());
 }
 
-void ResponseCurveComponent::parameterValueChanged (int parameterIndex, float newValue)
+void ResponseCurveComponent::visibilityChanged()
 {
-    parametersChanged.set(true);
+    updateRefreshSource();
 }
 
-void ResponseCurveComponent::parameterGestureChanged (int parameterIndex, bool gestureIsStarting)
-{}
+void ResponseCurveComponent::parentHierarchyChanged()
+{
+    updateRefreshSource();
+}
+
+void ResponseCurveComponent::updateRefreshSource()
+{
+    // Only tied to the display while on screen, so a hidden or closed editor costs nothing
+    if (! isShowing())
+        vBlankAttachment.reset();
+    else if (vBlankAttachment == nullptr)
+        vBlankAttachment = std::make_unique<VBlankAttachment> (this, [this] { refresh(); });
+}
 
-void ResponseCurveComponent::timerCallback()
+void ResponseCurveComponent::refresh()
 {
-    if( parametersChanged.compareAndSetBool(false, true) )
+    // Minimised windows keep their attachment but skip the work
+    if (! isShowing())
+        return;
+    
+    Rectangle<float> dirty;
+    
+    // The curve follows what the audio thread has actually applied; both the old and the
+    // new curve have to be repainted
+    if (audioProcessor.getLatestFilterSetup (filterSetup))
+    {
+        dirty = responseCurve.getBounds().expanded (2.0f);
         updateResponseCurve();
+        dirty = dirty.getUnion (responseCurve.getBounds().expanded (2.0f));
+    }
+    
+    // Nothing to fetch while the analyzer is off; the old frame is dropped so it doesn't
+    // flash up when it is switched on again
+    auto& analyzer = audioProcessor.getSpectrumAnalyzer();
+    
+    if (analyzer.isEnabled())
+    {
+        if (analyzer.getLatestSpectrum (spectrum))
+        {
+            hasSpectrum = true;
+            updateSpectrumCurves();
+            dirty = dirty.getUnion (getPlotArea().toFloat());
+        }
+    }
+    else if (hasSpectrum)
+    {
+        hasSpectrum = false;
+        dirty = dirty.getUnion (getPlotArea().toFloat());
+    }
+    
+    if (! dirty.isEmpty())
+        submitLayers (dirty);
+    
+    // A frame covers everything submitted up to its own sequence number; anything newer
+    // stays dirty until the frame that includes it arrives
+    if (curveRenderer.pullFrame())
+    {
+        repaint (dirtySinceShown.getSmallestIntegerContainer());
+        
+        if (curveRenderer.getFrame().sequence == submittedSequence)
+            dirtySinceShown = {};
+    }
+}
+
+void ResponseCurveComponent::submitLayers (Rectangle<float> dirty)
+{
+    dirtySinceShown = dirtySinceShown.getUnion (dirty);
+    
+    auto& layers = curveRenderer.getLayersToSubmit();
+    
+    layers.responseCurve = responseCurve;
+    layers.spectrumCurves = spectrumCurves;
+    layers.peakCurves = peakCurves;
+    layers.hasSpectrum = hasSpectrum;
+    layers.bounds = getLocalBounds();
+    layers.plotArea = getPlotArea().toFloat();
+    layers.scale = paintScale;
+    layers.sequence = ++submittedSequence;
+    
+    curveRenderer.submit();
+}
+
+Rectangle<int> ResponseCurveComponent::getPlotArea() const
+{
+    auto areaResponse = getLocalBounds();
+    areaResponse.removeFromTop(16);
+    areaResponse.removeFromBottom(6);
+    areaResponse.removeFromLeft(20);
+    areaResponse.removeFromRight(20);
+    return areaResponse;
+}
+
+void ResponseCurveComponent::updateSpectrumCurves()
+{
+    if (! hasSpectrum)
+        return;
+    
+    auto areaResponse = getLocalBounds();
+    areaResponse.removeFromTop(16);
+    areaResponse.removeFromBottom(6);
+    areaResponse.removeFromLeft(20);
+    areaResponse.removeFromRight(20);
     
-    repaint();
+    constexpr auto numPoints = Dsp::SpectrumAnalyzer::numPoints;
+    
+    const auto left = (float) areaResponse.getX();
+    const auto xScale = (float) areaResponse.getWidth() / (float) (numPoints - 1);
+    const auto bottom = (float) areaResponse.getBottom();
+    const auto top = (float) areaResponse.getY();
+    
+    const auto toY = [&] (float decibels)
+    {
+        return jmap (jlimit (spectrumMinDb, spectrumMaxDb, decibels), spectrumMinDb, spectrumMaxDb, bottom, top);
+    };
+    
+    const auto buildCurve = [&] (Path& path, const std::array<float, numPoints>& levels)
+    {
+        path.clear();
+        path.preallocateSpace (numPoints * 3);
+        path.startNewSubPath (left, toY (levels[0]));
+        
+        for (int i = 1; i < numPoints; ++i)
+            path.lineTo (left + (float) i * xScale, toY (levels[(size_t) i]));
+    };
+    
+    for (size_t tap = 0; tap < (size_t) Dsp::SpectrumAnalyzer::numTaps; ++tap)
+    {
+        buildCurve (spectrumCurves[tap], spectrum.level[tap]);
+        buildCurve (peakCurves[tap], spectrum.peak[tap]);
+    }
 }
 
 void ResponseCurveComponent::updateResponseCurve()
@@ -70,71 +202,122 @@ void ResponseCurveComponent::updateResponseCurve()
     areaResponse.removeFromLeft(20);
     areaResponse.removeFromRight(20);
 
-    Array<double> magnitudes;
-    auto w = areaResponse.getWidth();
-    auto sampleRate = audioProcessor.getSampleRate();
+    const auto w = areaResponse.getWidth();
+
+    responseCurve.clear();
 
-    magnitudes.clear();
+    if (w <= 0)
+        return;
 
-    using ChainPosition = SimpleEQAudioProcessor::ChainPosition;
+    if (w != tableWidth || filterSetup.sampleRate != tableSampleRate)
+        rebuildFrequencyTable (w, filterSetup.sampleRate);
 
-    for (int i = 0; i < w; ++i)
+    // 只重新计算系数变化了的频段，旁通的频段保留旧缓存
+    for (size_t band = 0; band < bandResponses.size(); ++band)
     {
-        double mag = 1.0f;
+        auto& response = bandResponses[band];
 
-        if (!audioProcessor.leftChain.isBypassed<ChainPosition::lowCut>())
-        {
-            auto freq = mapToLog10 (double(i) / double(w), 20.0, 20000.0);
-            mag *= audioProcessor.leftChain.get<ChainPosition::lowCut>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
+        if (! filterSetup.bypassed[band] && (! response.valid || response.coefficients != filterSetup.coefficients[band]))
+            updateBandResponse (response, filterSetup.coefficients[band]);
+    }
 
-        if (!audioProcessor.leftChain.isBypassed<ChainPosition::filter2>())
-        {
-            auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-            mag *= audioProcessor.leftChain.get<ChainPosition::filter2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
+    const double outputMin = areaResponse.getBottom();
+    const double outputMax = areaResponse.getY();
 
-        if (!audioProcessor.leftChain.isBypassed<ChainPosition::filter3>())
-        {
-            auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-            mag *= audioProcessor.leftChain.get<ChainPosition::filter3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
+    for (size_t pack = 0; pack < pixelPhi.size(); ++pack)
+    {
+        auto numerator = Vec::expand (1.0);
+        auto denominator = Vec::expand (1.0);
 
-        if (!audioProcessor.leftChain.isBypassed<ChainPosition::filter4>())
+        for (size_t band = 0; band < bandResponses.size(); ++band)
         {
-            auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-            mag *= audioProcessor.leftChain.get<ChainPosition::filter4>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
+            if (filterSetup.bypassed[band])
+                continue;
 
-        if (!audioProcessor.leftChain.isBypassed<ChainPosition::filter5>())
-        {
-            auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-            mag *= audioProcessor.leftChain.get<ChainPosition::filter5>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+            numerator *= bandResponses[band].numerator[pack];
+            denominator *= bandResponses[band].denominator[pack];
         }
 
-        if (!audioProcessor.leftChain.isBypassed<ChainPosition::highCut>())
+        for (size_t lane = 0; lane < Vec::size(); ++lane)
         {
-            auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-            mag *= audioProcessor.leftChain.get<ChainPosition::highCut>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+            const auto i = (int) (pack * Vec::size() + lane);
+
+            if (i >= w)
+                break;
+
+            // 以 dB 绘制；陷波的 -inf 限制在绘图区外一点
+            const auto gainDb = jlimit (-30.0, 30.0, 10.0 * std::log10 (numerator.get (lane) / denominator.get (lane) + 1.0e-30));
+            const auto y = (float) jmap (gainDb, -24.0, 24.0, outputMin, outputMax);
+
+            if (i == 0)
+                responseCurve.startNewSubPath ((float) areaResponse.getX(), y);
+            else
+                responseCurve.lineTo ((float) (areaResponse.getX() + i), y);
         }
+    }
+}
+
+void ResponseCurveComponent::rebuildFrequencyTable (int width, double sampleRate)
+{
+    tableWidth = width;
+    tableSampleRate = sampleRate;
 
+    const auto numPacks = ((size_t) width + Vec::size() - 1) / Vec::size();
+    pixelPhi.assign (numPacks, Vec::expand (0.0));
 
-        magnitudes.add(mag);
+    // 像素 i 对应的频率与网格线一致：20 Hz 到 20 kHz 的对数刻度
+    for (size_t i = 0; i < numPacks * Vec::size(); ++i)
+    {
+        const auto freq = mapToLog10 (double (i) / double (width), 20.0, 20000.0);
+        const auto halfOmegaSine = std::sin (MathConstants<double>::pi * freq / sampleRate);
+        pixelPhi[i / Vec::size()].set (i % Vec::size(), halfOmegaSine * halfOmegaSine);
     }
 
-    responseCurve.clear();
+    for (auto& response : bandResponses)
+        response.valid = false;
+}
 
-    const double outputMin = areaResponse.getBottom();
-    const double outputMax = areaResponse.getY();
+void ResponseCurveComponent::updateBandResponse (BandResponse& response, const Dsp::BiquadCoefficients& c)
+{
+    // |H(e^jω)|² written in φ = sin²(ω/2) rather than e^-jω: the terms near DC don't cancel,
+    // so low cuts stay accurate even at oversampled design rates
+    const auto n0 = Vec::expand (square (c.b0 + c.b1 + c.b2));
+    const auto n1 = Vec::expand (-4.0 * (c.b0 * c.b1 + 4.0 * c.b0 * c.b2 + c.b1 * c.b2));
+    const auto n2 = Vec::expand (16.0 * c.b0 * c.b2);
 
-    auto y = jmap(magnitudes[0], -24.0, 24.0, outputMin, outputMax);
-    responseCurve.startNewSubPath(areaResponse.getX(), y);
+    const auto d0 = Vec::expand (square (1.0 + c.a1 + c.a2));
+    const auto d1 = Vec::expand (-4.0 * (c.a1 + 4.0 * c.a2 + c.a1 * c.a2));
+    const auto d2 = Vec::expand (16.0 * c.a2);
 
-    for (int i = 1; i < magnitudes.size(); ++i)
+    response.numerator.resize (pixelPhi.size());
+    response.denominator.resize (pixelPhi.size());
+
+    for (size_t pack = 0; pack < pixelPhi.size(); ++pack)
     {
-        auto y = jmap(magnitudes[i], -24.0, 24.0, outputMin, outputMax);
-        responseCurve.lineTo(areaResponse.getX() + i, y);
+        const auto phi = pixelPhi[pack];
+
+        response.numerator[pack] = n0 + phi * (n1 + phi * n2);
+        response.denominator[pack] = d0 + phi * (d1 + phi * d2);
     }
+
+    response.coefficients = c;
+    response.valid = true;
+}
+
+void ResponseCurveComponent::renderStaticLayer (float scale)
+{
+    staticLayerScale = scale;
+    staticLayer = Image (Image::RGB,
+                         jmax (1, roundToInt ((float) getWidth() * scale)),
+                         jmax (1, roundToInt ((float) getHeight() * scale)),
+                         false);
+    
+    // Drawn at physical resolution, so the blit in paint() is one to one
+    Graphics g (staticLayer);
+    g.addTransform (AffineTransform::scale (scale));
+    
+    drawBackgroundGrid (g);
+    drawTextLabels (g);
 }
 
 void ResponseCurveComponent::drawBackgroundGrid (juce::Graphics& g)
@@ -228,8 +411,6 @@ void ResponseCurveComponent::drawTextLabels (juce::Graphics& g)
 SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p), presetPannel (p.getPresetManager()), responseCurveComponent (audioProcessor)
 {
-    setSize (800,500);
-    startTimer (100);
 
     background = ImageCache::getFromMemory(BinaryData::TDMovieOut_0_png, BinaryData::TDMovieOut_0_pngSize);
     
@@ -279,6 +460,10 @@ SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcess
     analysisButton.setColour(TextButton::ColourIds::buttonColourId, juce::Colours::darkorange);
     analysisButton.setColour(TextButton::ColourIds::buttonOnColourId, juce::Colours::orange);
     analysisButton.setLookAndFeel(&eqLNF);
+    analysisButton.onClick = [this]
+    {
+        audioProcessor.getSpectrumAnalyzer().setEnabled (analysisButton.getToggleState());
+    };
 
     freqButtons.clear();
     for (int i = 0; i < 6; ++i)
@@ -378,19 +563,37 @@ SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcess
     
     // 配置曲线显示模块
     addAndMakeVisible (responseCurveComponent);
+    
+    // 所有子组件创建完成后再设置尺寸，resized() 只在尺寸变化时调用一次
+    setSize (800,500);
 }
 
 SimpleEQAudioProcessorEditor::~SimpleEQAudioProcessorEditor()
 {
+    // Nobody is looking any more, so the analyzer stops costing anything
+    audioProcessor.getSpectrumAnalyzer().setEnabled (false);
 }
 
 //==============================================================================
 void SimpleEQAudioProcessorEditor::paint(juce::Graphics &g)
 {
-
-    g.drawImage(background,
-        0, 0, 800, 500,
-        0, 0, 1280, 720);
+    // Rescaling the 1280x720 source is by far the most expensive part of this paint, so
+    // it's only done when the display scale changes
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    
+    if (scaledBackground.isNull() || scale != scaledBackgroundScale)
+    {
+        scaledBackgroundScale = scale;
+        scaledBackground = Image (Image::RGB, roundToInt (800.0f * scale), roundToInt (500.0f * scale), false);
+        
+        Graphics bg (scaledBackground);
+        bg.setImageResamplingQuality (Graphics::highResamplingQuality);
+        bg.drawImage (background,
+            0, 0, scaledBackground.getWidth(), scaledBackground.getHeight(),
+            0, 0, 1280, 720);
+    }
+    
+    g.drawImage (scaledBackground, Rectangle<float> (0.0f, 0.0f, 800.0f, 500.0f));
 
     auto width = getWidth();
     auto height = getHeight();
@@ -665,10 +868,3 @@ void SimpleEQAudioProcessorEditor::mouseDown(const MouseEvent& event)
         repaint();
     }
 }
-
-void SimpleEQAudioProcessorEditor::timerCallback()
-{
-    // 判断初始化完成，进行绘制
-    if (freqButtons.size() == 6)
-        resized();
-}
@@ -11,11 +11,10 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "PresetPanel.h"
+#include "CurveRenderer.h"
 
 //==============================================================================
-class ResponseCurveComponent: public juce::Component,
-                                     juce::AudioProcessorParameter::Listener,
-                                     juce::Timer
+class ResponseCurveComponent: public juce::Component
 {
 public:
     ResponseCurveComponent (SimpleEQAudioProcessor&);
@@ -23,11 +22,8 @@ public:
     
     void paint(juce::Graphics& g) override;
     void resized() override;
-    
-    void parameterValueChanged (int parameterIndex, float newValue) override;
-    void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override;
-    
-    void timerCallback() override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
     
     void updateResponseCurve();
     Path responseCurve;
@@ -35,7 +31,37 @@ public:
 private:
     SimpleEQAudioProcessor& audioProcessor;
     
-    juce::Atomic<bool> parametersChanged { false };
+    // A consistent copy of the bands, published by the audio thread
+    Dsp::FilterSetup filterSetup;
+    
+    // 曲线计算：每个像素的 sin²(ω/2)，按 SIMD 宽度打包，只在宽度或采样率变化时重建
+    using Vec = juce::dsp::SIMDRegister<double>;
+    std::vector<Vec> pixelPhi;
+    int tableWidth = 0;
+    double tableSampleRate = 0.0;
+    
+    // 每个频段的 |分子|² 和 |分母|² 缓存，只有系数变化的频段才重新计算
+    struct BandResponse
+    {
+        Dsp::BiquadCoefficients coefficients;
+        std::vector<Vec> numerator, denominator;
+        bool valid = false;
+    };
+    
+    std::array<BandResponse, Dsp::FilterSetup::numBands> bandResponses;
+    
+    void rebuildFrequencyTable (int width, double sampleRate);
+    void updateBandResponse (BandResponse& response, const Dsp::BiquadCoefficients& coefficients);
+    
+    // 频谱分析：最新一帧及其路径，前后各一条电平曲线和峰值保持曲线
+    Dsp::SpectrumAnalyzer::Spectrum spectrum;
+    std::array<Path, Dsp::SpectrumAnalyzer::numTaps> spectrumCurves, peakCurves;
+    bool hasSpectrum = false;
+    
+    // 频谱的幅度范围，独立于曲线的 ±24 dB
+    static constexpr float spectrumMinDb = -90.0f, spectrumMaxDb = 6.0f;
+    
+    void updateSpectrumCurves();
     
     // 频率轴
     Array<float> frequencies { 20, 50, 100,
@@ -48,6 +74,27 @@ private:
     
     void drawBackgroundGrid (juce::Graphics& g);
     void drawTextLabels (juce::Graphics& g);
+    
+    // 静态层：背景、网格和文字，按尺寸和显示缩放渲染一次，之后直接贴图
+    Image staticLayer;
+    float staticLayerScale = 0.0f;
+    
+    void renderStaticLayer (float scale);
+    
+    // 刷新：每次垂直同步检查一次新数据，只重绘变化的区域；不在屏幕上时不挂接
+    std::unique_ptr<VBlankAttachment> vBlankAttachment;
+    
+    void updateRefreshSource();
+    void refresh();
+    Rectangle<int> getPlotArea() const;
+    
+    // 动态层（曲线和频谱）在后台线程栅格化，这里只合成最新完成的一帧
+    Gui::CurveRenderer curveRenderer;
+    float paintScale = 1.0f;
+    uint32 submittedSequence = 0;
+    Rectangle<float> dirtySinceShown;
+    
+    void submitLayers (Rectangle<float> dirty);
 };
 
 //==============================================================================
@@ -136,8 +183,7 @@ class SimpleEQLookAndFeel : public LookAndFeel_V4
 };
 
 //==============================================================================
-class SimpleEQAudioProcessorEditor  : public juce::AudioProcessorEditor,
-public Timer
+class SimpleEQAudioProcessorEditor  : public juce::AudioProcessorEditor
 {
 public:
     SimpleEQAudioProcessorEditor (SimpleEQAudioProcessor&);
@@ -149,8 +195,6 @@ public:
     
     int selectedFilter = 1;
     void mouseDown (const MouseEvent& event) override;
-    
-    void timerCallback() override;
 
 private:
     // This reference is provided as a quick way for your editor to
@@ -160,6 +204,10 @@ private:
     SimpleEQLookAndFeel eqLNF;
 
     Image background;
+    
+    // 缩放到编辑器尺寸和显示缩放的背景，只在两者变化时重新缩放
+    Image scaledBackground;
+    float scaledBackgroundScale = 0.0f;
 
     Gui::PresetPanel presetPannel;
     
@@ -9,6 +9,7 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include "PresetManager.h"
+#include "BiquadDesigner.h"
 
 //==============================================================================
 SimpleEQAudioProcessor::SimpleEQAudioProcessor()
@@ -25,10 +26,15 @@ SimpleEQAudioProcessor::SimpleEQAudioProcessor()
 {
     apvts.state.setProperty(Service::PresetManager::presetNameProperty,"", nullptr);
     apvts.state.setProperty("version", ProjectInfo::versionString, nullptr);
-    presetManager = std::make_unique<Service::PresetManager>(apvts);
+    presetManager = std::make_unique<Service::PresetManager>(apvts, [this] (const ValueTree& state) { applyParameterState (state); });
     
-    apvts.addParameterListener ("Scale", this);
-    apvts.addParameterListener ("Gain", this);
+    smoothingBlockParameter = apvts.getRawParameterValue ("SmoothingBlock");
+    multicoreParameter = apvts.getRawParameterValue ("Multicore");
+    phaseModeParameter = apvts.getRawParameterValue ("PhaseMode");
+    linearPhaseQualityParameter = apvts.getRawParameterValue ("LinearPhaseQuality");
+    oversamplingParameter = apvts.getRawParameterValue ("Oversampling");
+    designParameter = apvts.getRawParameterValue ("Design");
+    precisionParameter = apvts.getRawParameterValue ("Precision");
     
     for (int i = 1; i <= 6; ++i)
     {
@@ -47,16 +53,36 @@ SimpleEQAudioProcessor::SimpleEQAudioProcessor()
         String QString ("Q");
         QString << i;
         
-        apvts.addParameterListener (bypassString, this);
-        apvts.addParameterListener (typeString, this);
-        apvts.addParameterListener (freqString, this);
-        apvts.addParameterListener (gainString, this);
-        apvts.addParameterListener (QString, this);
+        auto& values = bandParameters[(size_t) i - 1];
+        
+        values[bypassValue] = apvts.getRawParameterValue (bypassString);
+        values[typeValue] = apvts.getRawParameterValue (typeString);
+        values[freqValue] = apvts.getRawParameterValue (freqString);
+        values[gainValue] = apvts.getRawParameterValue (gainString);
+        values[qValue] = apvts.getRawParameterValue (QString);
+    }
+    
+    for (auto* parameter : getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+        {
+            stateKeys.emplace_back (hashParameterID (ranged->paramID), stateParameters.size());
+            stateParameters.push_back (ranged);
+        }
     }
+    
+    std::sort (stateKeys.begin(), stateKeys.end());
+    
+    // Two IDs with the same key can't be told apart in a saved state. In every build
+    // findStateKey() turns such a key down, so both parameters are left out of a restore
+    // rather than one getting the other's value; renaming one of the IDs fixes it
+    jassert (std::adjacent_find (stateKeys.begin(), stateKeys.end(),
+                                 [] (const auto& a, const auto& b) { return a.first == b.first; }) == stateKeys.end());
 }
 
 SimpleEQAudioProcessor::~SimpleEQAudioProcessor()
 {
+    stopTimer();
 }
 
 //==============================================================================
@@ -131,77 +157,62 @@ void SimpleEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
     
     spec.maximumBlockSize = samplesPerBlock;
     
-    spec.numChannels = 1;
+    spec.numChannels = getTotalNumOutputChannels();
     
     spec.sampleRate = sampleRate;
     
-    leftChain.prepare (spec);
-    rightChain.prepare (spec);
+    // One worker per channel group beyond the one the audio thread takes itself; double
+    // registers hold half as many channels, so they set the upper bound
+    const auto laneCount = Dsp::EQEngine<double>::Vec::size();
+    const auto numGroups = (int) ((spec.numChannels + laneCount - 1) / laneCount);
     
-    // 配置滤波器默认值
-    // lowCut
-    auto& leftLowCut = leftChain.get<ChainPosition::lowCut>();
-    auto& rightLowCut = rightChain.get<ChainPosition::lowCut>();
+    dropWorkerPools();
+    numPoolWorkers = jmax (0, jmin (numGroups - 1, SystemStats::getNumPhysicalCpus() - 1));
+    poolBlockPeriodMs = 1000.0 * samplesPerBlock / sampleRate;
     
-    auto lowCutCoefficients = dsp::IIR::Coefficients<float>::makeHighPass (getSampleRate(), lowCutFreq, lowCutQ);
+    // Nothing is processing yet, so the engines can take the pool straight away
+    updateWorkerPool();
+    followWorkerPool();
     
-    updateCoefficients (leftLowCut.coefficients, lowCutCoefficients);
-    updateCoefficients (rightLowCut.coefficients, lowCutCoefficients);
+    preparedSpec = spec;
     
-    // filter2
-
-    auto& leftFilter2 = leftChain.get<ChainPosition::filter2>();
-    auto& rightFilter2 = rightChain.get<ChainPosition::filter2>();
-
-    auto filter2Coefficients = dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), filter2Freq, filter2Q, filter2Gain);
-
-    updateCoefficients(leftFilter2.coefficients, filter2Coefficients);
-    updateCoefficients(rightFilter2.coefficients, filter2Coefficients);
-
-    // filter3
-
-    auto& leftFilter3 = leftChain.get<ChainPosition::filter3>();
-    auto& rightFilter3 = rightChain.get<ChainPosition::filter3>();
-
-    auto filter3Coefficients = dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), filter3Freq, filter3Q, filter3Gain);
-
-    updateCoefficients(leftFilter3.coefficients, filter3Coefficients);
-    updateCoefficients(rightFilter3.coefficients, filter3Coefficients);
-
-    // filter4
-
-    auto& leftFilter4 = leftChain.get<ChainPosition::filter4>();
-    auto& rightFilter4 = rightChain.get<ChainPosition::filter4>();
-
-    auto filter4Coefficients = dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), filter4Freq, filter4Q, filter4Gain);
-
-    updateCoefficients(leftFilter4.coefficients, filter4Coefficients);
-    updateCoefficients(rightFilter4.coefficients, filter4Coefficients);
-
-    // filter5
+    prepareChain (floatChain, samplesPerBlock);
+    prepareChain (doubleChain, samplesPerBlock);
     
-    auto& leftFilter5 = leftChain.get<ChainPosition::filter5>();
-    auto& rightFilter5 = rightChain.get<ChainPosition::filter5>();
-
-    auto filter5Coefficients = dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), filter5Freq, filter5Q, filter5Gain);
-
-    updateCoefficients(leftFilter5.coefficients, filter5Coefficients);
-    updateCoefficients(rightFilter5.coefficients, filter5Coefficients);
-
-    // highCut
-    auto& leftHighCut = leftChain.get<ChainPosition::highCut>();
-    auto& rightHighCut = rightChain.get<ChainPosition::highCut>();
-
-    auto highCutCoefficients = dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), highCutFreq, highCutQ);
-
-    updateCoefficients(leftHighCut.coefficients, highCutCoefficients);
-    updateCoefficients(rightHighCut.coefficients, highCutCoefficients);
+    doubleScratch.setSize ((int) spec.numChannels, samplesPerBlock);
+    floatScratch.setSize ((int) spec.numChannels, samplesPerBlock);
+    doubleStateWasActive = usesDoubleState();
+    
+    // Prepares the engines at the processing rate; the sample rate may have changed,
+    // so every band is designed again
+    setOversampling (jlimit (0, Dsp::Oversampler<float>::maxFactorLog2, (int) oversamplingParameter->load()));
+    
+    // Convolvers only exist in linear phase mode. Built here, before the first block, they
+    // start with the kernel for the setup just designed, so even an offline render that
+    // begins straight away is filtered from its first sample
+    linearPhase.prepare (spec);
+    
+    if (isLinearPhase())
+        linearPhase.enable ((int) linearPhaseQualityParameter->load(), filterSetup);
+    
+    linearPhaseWasActive = isLinearPhase();
+    
+    // The analyzer sees the signal at the host rate, before and after any oversampling
+    spectrumAnalyzer.prepare (sampleRate);
+    
+    setLatencySamples (getCurrentLatencySamples());
+    startTimerHz (10);
 }
 
 void SimpleEQAudioProcessor::releaseResources()
 {
-    leftChain.reset();
-    rightChain.reset();
+    stopTimer();
+    
+    floatChain.engine.reset();
+    doubleChain.engine.reset();
+    linearPhase.release();
+    
+    dropWorkerPools();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -211,12 +222,16 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (//layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo()
-        layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Every band runs on all channels of the bus, so any of the usual layouts from mono
+    // up to 7.1.4 works; the engine sizes its state for the channel count in prepareToPlay
+    const auto& output = layouts.getMainOutputChannelSet();
+
+    if (output != juce::AudioChannelSet::mono()
+        && output != juce::AudioChannelSet::stereo()
+        && output != juce::AudioChannelSet::createLCR()
+        && output != juce::AudioChannelSet::create5point1()
+        && output != juce::AudioChannelSet::create7point1()
+        && output != juce::AudioChannelSet::create7point1point4())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -232,6 +247,24 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 
 void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    processSamples (buffer);
+}
+
+void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples (buffer);
+}
+
+bool SimpleEQAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void SimpleEQAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer)
+{
+    // Audit builds record anything on this thread that allocates, locks or blocks
+    const Dsp::RealtimeAudit::ScopedAudioThread audioThread;
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -245,15 +278,113 @@ void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-    juce::dsp::AudioBlock<float> block(buffer);
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    const auto oversampling = jlimit (0, Dsp::Oversampler<float>::maxFactorLog2, (int) oversamplingParameter->load());
+    
+    if (oversampling != oversamplingIndex)
+        setOversampling (oversampling);
+    
+    const auto smoothingBlockSize = getSmoothingBlockSize ((int) smoothingBlockParameter->load());
+    const auto multicore = multicoreParameter->load() >= 0.5f;
+    
+    followWorkerPool();
+    
+    floatChain.engine.setSmoothingBlockSize (smoothingBlockSize);
+    floatChain.engine.setMulticoreEnabled (multicore);
+    doubleChain.engine.setSmoothingBlockSize (smoothingBlockSize);
+    doubleChain.engine.setMulticoreEnabled (multicore);
+    
+    // Only bands whose parameters moved since the last block are redesigned, once each,
+    // however many automation points arrived in between; the engine ramps towards them
+    updateFilterSetup (false);
+    
+    juce::dsp::AudioBlock<SampleType> block(buffer);
     
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    // Both taps return straight away while the analyzer is off
+    spectrumAnalyzer.pushSamples (Dsp::SpectrumAnalyzer::preTap, block);
     
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    // Until the message thread has built the convolvers for a switch to linear phase, the
+    // minimum phase path carries on
+    const auto linear = linearPhase.beginBlock (filterSetup) && isLinearPhase();
+    const auto doubleState = std::is_same<SampleType, double>::value || usesDoubleState();
+    
+    // Whichever path takes over starts from silence rather than from stale state
+    if (linear != linearPhaseWasActive || doubleState != doubleStateWasActive)
+    {
+        if (linear)
+            linearPhase.reset();
+        else if (doubleState)
+            doubleChain.engine.reset();
+        else
+            floatChain.engine.reset();
+        
+        linearPhaseWasActive = linear;
+        doubleStateWasActive = doubleState;
+    }
+    
+    if constexpr (std::is_same<SampleType, float>::value)
+    {
+        if (linear)
+        {
+            linearPhase.process (block);
+        }
+        else if (doubleState)
+        {
+            doubleScratch.makeCopyOf (buffer, true);
+            processChain (doubleChain, juce::dsp::AudioBlock<double> (doubleScratch));
+            buffer.makeCopyOf (doubleScratch, true);
+        }
+        else
+        {
+            processChain (floatChain, block);
+        }
+    }
+    else
+    {
+        if (linear)
+        {
+            // The convolution only comes in float; its FFTs are the precision limit anyway
+            floatScratch.makeCopyOf (buffer, true);
+            linearPhase.process (juce::dsp::AudioBlock<float> (floatScratch));
+            buffer.makeCopyOf (floatScratch, true);
+        }
+        else
+        {
+            processChain (doubleChain, block);
+        }
+    }
+    
+    spectrumAnalyzer.pushSamples (Dsp::SpectrumAnalyzer::postTap, block);
+}
+
+template <typename SampleType>
+void SimpleEQAudioProcessor::processChain (ProcessingChain<SampleType>& chain, const juce::dsp::AudioBlock<SampleType>& block)
+{
+    if (oversamplingIndex > 0)
+    {
+        // The oversampler holds twice the host block, so 4x and 8x go in two or four pieces
+        auto& oversampler = chain.oversampler;
+        const auto numSamples = block.getNumSamples();
+        const auto pieceSize = oversampler.getMaxHostSamples();
+        
+        for (size_t start = 0; start < numSamples; start += pieceSize)
+        {
+            const auto piece = block.getSubBlock (start, jmin (pieceSize, numSamples - start));
+            
+            chain.engine.process (oversampler.processSamplesUp (piece));
+            oversampler.processSamplesDown (piece);
+        }
+    }
+    else
+    {
+        chain.engine.process (block);   // All channels go through the cascade together, one SIMD lane each
+    }
+}
+
+template <typename SampleType>
+void SimpleEQAudioProcessor::prepareChain (ProcessingChain<SampleType>& chain, int samplesPerBlock)
+{
+    // One set of buffers serves 2x, 4x and 8x alike, so switching never allocates
+    chain.oversampler.prepare (preparedSpec.numChannels, (size_t) samplesPerBlock);
 }
 
 //==============================================================================
@@ -271,200 +402,151 @@ juce::AudioProcessorEditor* SimpleEQAudioProcessor::createEditor()
 //==============================================================================
 void SimpleEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
+    // A few hundred bytes written straight from the parameters, without building a ValueTree
+    // or XML. Values are stored denormalised and keyed by a hash of their ID, so ranges and
+    // the parameter order can change without breaking older sessions
+    destData.reset();
+    juce::MemoryOutputStream stream (destData, false);
+    
+    stream.writeInt (stateMagic);
+    stream.writeShort ((short) stateFormatVersion);
+    stream.writeString (ProjectInfo::versionString);
+    stream.writeString (apvts.state.getProperty (Service::PresetManager::presetNameProperty).toString());
+    stream.writeShort ((short) stateKeys.size());
+    
+    for (const auto& [key, index] : stateKeys)
+    {
+        const auto* parameter = stateParameters[index];
+        
+        stream.writeInt ((int) key);
+        stream.writeFloat (parameter->convertFrom0to1 (parameter->getValue()));
+    }
 }
 
 void SimpleEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-}
-
-void SimpleEQAudioProcessor::parameterChanged (const String &parameterID, float newValue)
-{
-    DBG (parameterID);
-    DBG (std::to_string (newValue));
+    juce::MemoryInputStream stream (data, (size_t) jmax (0, sizeInBytes), false);
+    
+    if (stream.getNumBytesRemaining() < 6 || stream.readInt() != stateMagic)
+        return;
+    
+    // Any other format may mean something else by the same bytes
+    if ((int) stream.readShort() != stateFormatVersion)
+        return;
+    
+    stream.readString();   // The version that wrote it; nothing depends on it yet
+    const auto presetName = stream.readString();
+    const auto numValues = (int) (juce::uint16) stream.readShort();
+    
+    // Everything is parsed before anything is applied, so a truncated state changes nothing.
+    // Parameters the state doesn't mention, e.g. ones added since, go back to their defaults
+    std::vector<float> values;
+    values.reserve (stateParameters.size());
     
-    if (parameterID.startsWith ("Freq"))
+    for (const auto* parameter : stateParameters)
+        values.push_back (parameter->getDefaultValue());
+    
+    for (int i = 0; i < numValues; ++i)
     {
-        int lastDigit = String::charToString (parameterID.getLastCharacter()).getIntValue();
+        if (stream.getNumBytesRemaining() < 8)
+            return;
         
-        switch (lastDigit)
-        {
-            case 1:
-                lowCutFreq = newValue;
-                updateFilterSetup (1, FilterType::lowCutType, lowCutFreq, lowCutQ, 1.0f);
-                break;
-                
-            case 2:
-                filter2Freq = newValue;
-                updateFilterSetup (2, filter2Type, filter2Freq, filter2Q, filter2Gain);
-                break;
-                
-            case 3:
-                filter3Freq = newValue;
-                updateFilterSetup (3, filter3Type, filter3Freq, filter3Q, filter3Gain);
-                break;
-                
-            case 4:
-                filter4Freq = newValue;
-                updateFilterSetup (4, filter4Type, filter4Freq, filter4Q, filter4Gain);
-                break;
-                
-            case 5:
-                filter5Freq = newValue;
-                updateFilterSetup (5, filter5Type, filter5Freq, filter5Q, filter5Gain);
-                break;
-                
-            case 6:
-                highCutFreq = newValue;
-                updateFilterSetup (6, FilterType::highCutType, highCutFreq, highCutQ, 1.0f);
-                break;
-        }
-    }
-    else if (parameterID.startsWith ("Q"))
-    {
-        int lastDigit = String::charToString (parameterID.getLastCharacter()).getIntValue();
+        const auto key = (juce::uint32) stream.readInt();
+        const auto value = stream.readFloat();
         
-        switch (lastDigit)
-        {
-            case 1:
-                lowCutQ = newValue;
-                updateFilterSetup (1, FilterType::lowCutType, lowCutFreq, lowCutQ, 1.0f);
-                break;
-            
-            case 2:
-                filter2Q = newValue;
-                updateFilterSetup (2, filter2Type, filter2Freq, filter2Q, filter2Gain);
-                break;
-                
-            case 3:
-                filter3Q = newValue;
-                updateFilterSetup (3, filter3Type, filter3Freq, filter3Q, filter3Gain);
-                break;
-                
-            case 4:
-                filter4Q = newValue;
-                updateFilterSetup (4, filter4Type, filter4Freq, filter4Q, filter4Gain);
-                break;
-                
-            case 5:
-                filter5Q = newValue;
-                updateFilterSetup (5, filter5Type, filter5Freq, filter5Q, filter5Gain);
-                break;
-                
-            case 6:
-                highCutQ = newValue;
-                updateFilterSetup (6, FilterType::highCutType, highCutFreq, highCutQ, 1.0f);
-                break;
-        }
-    }
-    else if (parameterID.startsWith ("Gain"))
-    {
-        int lastDigit = String::charToString (parameterID.getLastCharacter()).getIntValue();
+        // IDs this build doesn't know are skipped
+        const auto index = findStateKey (stateKeys, key);
         
-        switch (lastDigit)
-        {
-            case 1:
-                updateFilterSetup (1, FilterType::lowCutType, lowCutFreq, lowCutQ, 1.0f);
-                break;
-            
-            case 2:
-                filter2Gain = Decibels::decibelsToGain (newValue);
-                updateFilterSetup (2, filter2Type, filter2Freq, filter2Q, filter2Gain);
-                break;
-                
-            case 3:
-                filter3Gain = Decibels::decibelsToGain (newValue);
-                updateFilterSetup (3, filter3Type, filter3Freq, filter3Q, filter3Gain);
-                break;
-                
-            case 4:
-                filter4Gain = Decibels::decibelsToGain (newValue);
-                updateFilterSetup (4, filter4Type, filter4Freq, filter4Q, filter4Gain);
-                break;
-                
-            case 5:
-                filter5Gain = Decibels::decibelsToGain (newValue);
-                updateFilterSetup (5, filter5Type, filter5Freq, filter5Q, filter5Gain);
-                break;
-                
-            case 6:
-                updateFilterSetup (6, FilterType::highCutType, highCutFreq, highCutQ, 1.0f);
-                break;
-        }
+        if (index >= 0)
+            values[(size_t) index] = stateParameters[(size_t) index]->convertTo0to1 (value);
     }
-    else if (parameterID.startsWith ("Type"))
+    
+    applyNormalisedValues (values);
+    apvts.state.setProperty (Service::PresetManager::presetNameProperty, presetName, nullptr);
+}
+
+juce::uint32 SimpleEQAudioProcessor::hashParameterID (const juce::String& parameterID)
+{
+    auto hash = (juce::uint32) 2166136261u;
+    
+    for (auto* c = parameterID.toRawUTF8(); *c != 0; ++c)
+        hash = (hash ^ (juce::uint32) (juce::uint8) *c) * (juce::uint32) 16777619u;
+    
+    return hash;
+}
+
+int SimpleEQAudioProcessor::findStateKey (const StateKeys& keys, juce::uint32 key)
+{
+    const auto found = std::lower_bound (keys.begin(), keys.end(), key,
+                                         [] (const auto& entry, juce::uint32 k) { return entry.first < k; });
+    
+    if (found == keys.end() || found->first != key)
+        return -1;
+    
+    if (std::next (found) != keys.end() && std::next (found)->first == key)
+        return -1;
+    
+    return (int) found->second;
+}
+
+int SimpleEQAudioProcessor::findStateParameter (const juce::String& parameterID) const
+{
+    const auto index = findStateKey (stateKeys, hashParameterID (parameterID));
+    
+    if (index < 0 || stateParameters[(size_t) index]->paramID != parameterID)
+        return -1;
+    
+    return index;
+}
+
+void SimpleEQAudioProcessor::applyParameterValues (const ParameterValues& values)
+{
+    std::vector<float> normalised;
+    normalised.reserve (stateParameters.size());
+    
+    for (const auto* parameter : stateParameters)
+        normalised.push_back (parameter->getValue());
+    
+    for (const auto& [parameterID, value] : values)
     {
-        int lastDigit = String::charToString (parameterID.getLastCharacter()).getIntValue();
+        const auto index = findStateParameter (parameterID);
         
-        switch (lastDigit)
-        {
-            case 1:
-                updateFilterSetup (1, FilterType::lowCutType, lowCutFreq, lowCutQ, 1.0f);
-                break;
-            
-            case 2:
-                filter2Type = static_cast<FilterType> (newValue);
-                updateFilterSetup (2, filter2Type, filter2Freq, filter2Q, filter2Gain);
-                break;
-                
-            case 3:
-                filter3Gain = static_cast<FilterType> (newValue);
-                updateFilterSetup (3, filter3Type, filter3Freq, filter3Q, filter3Gain);
-                break;
-                
-            case 4:
-                filter4Gain = static_cast<FilterType> (newValue);
-                updateFilterSetup (4, filter4Type, filter4Freq, filter4Q, filter4Gain);
-                break;
-                
-            case 5:
-                filter5Gain = static_cast<FilterType> (newValue);
-                updateFilterSetup (5, filter5Type, filter5Freq, filter5Q, filter5Gain);
-                break;
-                
-            case 6:
-                updateFilterSetup (6, FilterType::highCutType, highCutFreq, highCutQ, 1.0f);
-                break;
-        }
+        if (index >= 0)
+            normalised[(size_t) index] = stateParameters[(size_t) index]->convertTo0to1 (value);
     }
+    
+    applyNormalisedValues (normalised);
+}
 
-    else if (parameterID.startsWith("Bypass"))
-    {
-        int lastDigit = String::charToString(parameterID.getLastCharacter()).getIntValue();
-        bool flag = (newValue == 0.0f) ? false : true;
+void SimpleEQAudioProcessor::applyParameterState (const juce::ValueTree& state)
+{
+    ParameterValues values;
+    
+    for (const auto& child : state)
+        if (child.hasType ("PARAM") && child.hasProperty ("id"))
+            values[child["id"].toString()] = (float) child["value"];
+    
+    applyParameterValues (values);
+}
 
-        switch (lastDigit)
-        {
-            case 1:
-                leftChain.setBypassed<ChainPosition::lowCut>(flag);
-                rightChain.setBypassed<ChainPosition::lowCut>(flag);
-                break;
-
-            case 2:
-                leftChain.setBypassed<ChainPosition::filter2>(flag);
-                rightChain.setBypassed<ChainPosition::filter2>(flag);
-                break;
-
-            case 3:
-                leftChain.setBypassed<ChainPosition::filter3>(flag);
-                rightChain.setBypassed<ChainPosition::filter3>(flag);
-                break;
-
-            case 4:
-                leftChain.setBypassed<ChainPosition::filter4>(flag);
-                rightChain.setBypassed<ChainPosition::filter4>(flag);
-                break;
-
-            case 5:
-                leftChain.setBypassed<ChainPosition::filter5>(flag);
-                rightChain.setBypassed<ChainPosition::filter5>(flag);
-                break;
-
-            case 6:
-                leftChain.setBypassed<ChainPosition::highCut>(flag);
-                rightChain.setBypassed<ChainPosition::highCut>(flag);
-                break;
-        }
+void SimpleEQAudioProcessor::applyNormalisedValues (const std::vector<float>& values)
+{
+    jassert (values.size() == stateParameters.size());
+    
+    // Writer side of the seqlock in updateFilterSetup
+    const auto generation = transactionGeneration.load (std::memory_order_relaxed);
+    transactionGeneration.store (generation + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+    
+    for (size_t i = 0; i < stateParameters.size(); ++i)
+    {
+        auto* parameter = stateParameters[i];
+        
+        if (parameter->getValue() != values[i])
+            parameter->setValueNotifyingHost (values[i]);
     }
+    
+    transactionGeneration.store (generation + 2, std::memory_order_release);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::createParameterLayout()
@@ -490,7 +572,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::crea
         
         layout.add (std::make_unique<juce::AudioParameterBool> (juce::ParameterID {bypassString, 1},
                                                                 bypassString,
-                                                                true));
+                                                                false));
         
         String typeString ("Type");
         typeString << i;
@@ -562,195 +644,358 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::crea
                                                                  1.f));
     }
     
+    // 参数平滑：每隔多少个采样重新计算一次系数
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID {"SmoothingBlock", 1},
+                                                              "Smoothing Block",
+                                                              StringArray ("Off", "16", "32", "64"),
+                                                              2,
+                                                              juce::AudioParameterChoiceAttributes().withAutomatable (false)));
+    
+    // 线性相位模式：用对称 FIR 卷积代替 IIR，质量越高延迟越大、低频分辨率越高
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID {"PhaseMode", 1},
+                                                              "Phase Mode",
+                                                              StringArray ("Minimum", "Linear"),
+                                                              0,
+                                                              juce::AudioParameterChoiceAttributes().withAutomatable (false)));
+    
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID {"LinearPhaseQuality", 1},
+                                                              "Linear Phase Quality",
+                                                              StringArray ("Low", "Medium", "High"),
+                                                              1,
+                                                              juce::AudioParameterChoiceAttributes().withAutomatable (false)));
+    
+    // 系数设计方式：双线性变换（RBJ）或与模拟原型匹配的设计，后者在奈奎斯特附近不会压缩
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID {"Design", 1},
+                                                              "Design",
+                                                              StringArray ("Bilinear", "Analog Matched"),
+                                                              0,
+                                                              juce::AudioParameterChoiceAttributes().withAutomatable (false)));
+    
+    // 过采样：在更高采样率下运行 IIR 滤波器，避免高频处的频响压缩
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID {"Oversampling", 1},
+                                                              "Oversampling",
+                                                              StringArray ("Off", "2x", "4x", "8x"),
+                                                              0,
+                                                              juce::AudioParameterChoiceAttributes().withAutomatable (false)));
+    
+    // 计算精度：双精度状态在低频高 Q 时噪声更低；宿主提供双精度缓冲时始终使用双精度
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID {"Precision", 1},
+                                                              "Precision",
+                                                              StringArray ("Float", "Double State"),
+                                                              0,
+                                                              juce::AudioParameterChoiceAttributes().withAutomatable (false)));
+    
+    // 多核处理：多声道时把声道组分给工作线程，不划算时自动退回单线程
+    layout.add (std::make_unique<juce::AudioParameterBool> (juce::ParameterID {"Multicore", 1},
+                                                            "Multicore",
+                                                            false,
+                                                            juce::AudioParameterBoolAttributes().withAutomatable (false)));
+    
     return layout;
 }
 
-void SimpleEQAudioProcessor::updateFilterSetup (int filterIndex, FilterType type, float freq, float Q, float gain)
+int SimpleEQAudioProcessor::getSmoothingBlockSize (int choiceIndex)
+{
+    static constexpr int sizes[] { 0, 16, 32, 64 };
+    return sizes[jlimit (0, (int) std::size (sizes) - 1, choiceIndex)];
+}
+
+bool SimpleEQAudioProcessor::readParameterValues (AllBandValues& values, Dsp::DesignMethod& method) const
+{
+    // Reader side of the transaction seqlock: values read while a transaction was writing,
+    // or partly before and partly after one, are dropped
+    const auto generation = transactionGeneration.load (std::memory_order_acquire);
+    
+    if ((generation & 1) != 0)
+        return false;
+    
+    AllBandValues current;
+    
+    for (size_t band = 0; band < bandParameters.size(); ++band)
+        for (size_t i = 0; i < numBandValues; ++i)
+            current[band][i] = bandParameters[band][i]->load (std::memory_order_relaxed);
+    
+    const auto currentMethod = designParameter->load (std::memory_order_relaxed) >= 0.5f ? Dsp::matchedDesign
+                                                                                         : Dsp::bilinearDesign;
+    
+    std::atomic_thread_fence (std::memory_order_acquire);
+    
+    if (transactionGeneration.load (std::memory_order_relaxed) != generation)
+        return false;
+    
+    values = current;
+    method = currentMethod;
+    return true;
+}
+
+Dsp::BandParameters SimpleEQAudioProcessor::makeBandParameters (size_t band, const BandValues& values)
 {
-    if (filterIndex == 1)
+    // 第一个和最后一个滤波器固定为低切和高切
+    if (band == (size_t) ChainPosition::lowCut)
+        return { FilterType::lowCutType, values[freqValue], values[qValue], 1.0f };
+    
+    if (band == (size_t) ChainPosition::highCut)
+        return { FilterType::highCutType, values[freqValue], values[qValue], 1.0f };
+    
+    return { static_cast<FilterType> ((int) values[typeValue]),
+             values[freqValue],
+             values[qValue],
+             Decibels::decibelsToGain (values[gainValue]) };
+}
+
+void SimpleEQAudioProcessor::updateFilterSetup (bool forceAllBands)
+{
+    // Keeps the last complete set if a transaction is in the way
+    auto latest = appliedValues;
+    auto method = filterSetup.method;
+    readParameterValues (latest, method);
+    
+    if (method != filterSetup.method)
     {
-        auto& filterLeft = leftChain.get<ChainPosition::lowCut>();
-        auto& filterRight = rightChain.get<ChainPosition::lowCut>();
-        
-        auto lowCutCoefficients = dsp::IIR::Coefficients<float>::makeHighPass (getSampleRate(), freq, Q);
-        
-        updateCoefficients (filterLeft.coefficients, lowCutCoefficients);
-        updateCoefficients (filterRight.coefficients, lowCutCoefficients);
+        filterSetup.method = method;
+        forceAllBands = true;
     }
-    else if (filterIndex == 2)
+    
+    uint32 dirtyBands = 0;
+    
+    for (size_t band = 0; band < bandParameters.size(); ++band)
     {
-        auto& filterLeft = leftChain.get<ChainPosition::filter2>();
-        auto& filterRight = rightChain.get<ChainPosition::filter2>();
-        
-        if (type == FilterType::lowCutType)
+        if (forceAllBands || latest[band] != appliedValues[band])
         {
-            auto lowCutCoefficients = dsp::IIR::Coefficients<float>::makeHighPass (getSampleRate(), filter2Freq, filter2Q);
-            
-            updateCoefficients (filterLeft.coefficients, lowCutCoefficients);
-            updateCoefficients (filterRight.coefficients, lowCutCoefficients);
+            appliedValues[band] = latest[band];
+            dirtyBands |= 1u << band;
         }
-        else if (type == FilterType::highCutType)
-        {
-            auto highCutCoefficients = dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), filter2Freq, filter2Q);
+    }
+    
+    if (dirtyBands == 0)
+        return;
+    
+    for (size_t band = 0; band < bandParameters.size(); ++band)
+    {
+        if ((dirtyBands & (1u << band)) == 0)
+            continue;
+        
+        const auto& values = appliedValues[band];
+        
+        filterSetup.parameters[band] = makeBandParameters (band, values);
+        filterSetup.bypassed[band] = values[bypassValue] >= 0.5f;
+        
+        Dsp::BiquadDesigner::design (filterSetup.parameters[band], filterSetup.method, processingSampleRate,
+                                     filterSetup.coefficients[band]);
+    }
+    
+    filterSetup.sampleRate = processingSampleRate;
+    
+    floatChain.engine.setFilterSetup (filterSetup);
+    doubleChain.engine.setFilterSetup (filterSetup);
+    linearPhase.setFilterSetup (filterSetup);
+    publishFilterSetup();
+}
 
-            updateCoefficients(filterLeft.coefficients, highCutCoefficients);
-            updateCoefficients(filterRight.coefficients, highCutCoefficients);
-        }
-        else if (type == FilterType::bellType)
-        {
-            auto newCoefficients = dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), filter2Freq, filter2Q, filter2Gain);
+bool SimpleEQAudioProcessor::isLinearPhase() const
+{
+    return phaseModeParameter->load() >= 0.5f;
+}
 
-            updateCoefficients(filterLeft.coefficients, newCoefficients);
-            updateCoefficients(filterRight.coefficients, newCoefficients);
-        }
-        else if (type == FilterType::notchType)
-        {
-            auto newCoefficients = dsp::IIR::Coefficients<float>::makeNotch(getSampleRate(), filter2Freq, filter2Q);
+bool SimpleEQAudioProcessor::usesDoubleState() const
+{
+    return precisionParameter->load() >= 0.5f;
+}
 
-            updateCoefficients(filterLeft.coefficients, newCoefficients);
-            updateCoefficients(filterRight.coefficients, newCoefficients);
-        }
-        else if (type == FilterType::bandPassType)
-        {
-            auto newCoefficients = dsp::IIR::Coefficients<float>::makeBandPass(getSampleRate(), filter2Freq, filter2Q);
+Dsp::MulticoreStatus SimpleEQAudioProcessor::getMulticoreStatus() const
+{
+    if (isUsingDoublePrecision() || usesDoubleState())
+        return doubleChain.engine.getMulticoreStatus();
+    
+    return floatChain.engine.getMulticoreStatus();
+}
 
-            updateCoefficients(filterLeft.coefficients, newCoefficients);
-            updateCoefficients(filterRight.coefficients, newCoefficients);
-        }
+bool SimpleEQAudioProcessor::canCheckpointFilterState() const
+{
+    return ! isLinearPhase() && (int) oversamplingParameter->load() == 0;
+}
+
+void SimpleEQAudioProcessor::saveFilterState (FilterState& destination) const
+{
+    jassert (canCheckpointFilterState());
+    
+    if (isUsingDoublePrecision() || usesDoubleState())
+    {
+        doubleChain.engine.getState (destination.values);
     }
-    else if (filterIndex == 3)
+    else
     {
-        auto& filterLeft = leftChain.get<ChainPosition::filter3>();
-        auto& filterRight = rightChain.get<ChainPosition::filter3>();
-        
-        if (type == FilterType::lowCutType)
-        {
-            auto lowCutCoefficients = dsp::IIR::Coefficients<float>::makeHighPass (getSampleRate(), filter3Freq, filter3Q);
-            
-            updateCoefficients (filterLeft.coefficients, lowCutCoefficients);
-            updateCoefficients (filterRight.coefficients, lowCutCoefficients);
-        }
-        else if (type == FilterType::highCutType)
-        {
-            auto highCutCoefficients = dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), filter3Freq, filter3Q);
+        std::vector<float> values;
+        floatChain.engine.getState (values);
+        destination.values.assign (values.begin(), values.end());
+    }
+}
 
-            updateCoefficients(filterLeft.coefficients, highCutCoefficients);
-            updateCoefficients(filterRight.coefficients, highCutCoefficients);
-        }
-        else if (type == FilterType::bellType)
-        {
-            auto newCoefficients = dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), filter3Freq, filter3Q, filter3Gain);
+void SimpleEQAudioProcessor::restoreFilterState (const FilterState& source)
+{
+    jassert (canCheckpointFilterState());
+    
+    if (isUsingDoublePrecision() || usesDoubleState())
+        doubleChain.engine.setState (source.values);
+    else
+        floatChain.engine.setState (std::vector<float> (source.values.begin(), source.values.end()));
+}
 
-            updateCoefficients(filterLeft.coefficients, newCoefficients);
-            updateCoefficients(filterRight.coefficients, newCoefficients);
-        }
-        else if (type == FilterType::notchType)
-        {
-            auto newCoefficients = dsp::IIR::Coefficients<float>::makeNotch(getSampleRate(), filter3Freq, filter3Q);
+int SimpleEQAudioProcessor::getCurrentLatencySamples() const
+{
+    if (isLinearPhase())
+        return linearPhase.getLatencySamples();
+    
+    // Both chains use the same half-band design, so they have the same latency
+    const auto index = jlimit (0, Dsp::Oversampler<float>::maxFactorLog2, (int) oversamplingParameter->load());
+    
+    return roundToInt (Dsp::Oversampler<float>::getLatency (index));
+}
 
-            updateCoefficients(filterLeft.coefficients, newCoefficients);
-            updateCoefficients(filterRight.coefficients, newCoefficients);
-        }
-        else if (type == FilterType::bandPassType)
-        {
-            auto newCoefficients = dsp::IIR::Coefficients<float>::makeBandPass(getSampleRate(), filter3Freq, filter3Q);
+void SimpleEQAudioProcessor::setOversampling (int index)
+{
+    oversamplingIndex = index;
+    
+    auto spec = preparedSpec;
+    spec.sampleRate *= (double) (1 << index);
+    spec.maximumBlockSize <<= index;
+    
+    // Same channel count as before, so this only resets state and smoothing
+    floatChain.engine.prepare (spec);
+    doubleChain.engine.prepare (spec);
+    processingSampleRate = spec.sampleRate;
+    
+    floatChain.oversampler.setFactorLog2 (index);
+    doubleChain.oversampler.setFactorLog2 (index);
+    
+    updateFilterSetup (true);
+}
 
-            updateCoefficients(filterLeft.coefficients, newCoefficients);
-            updateCoefficients(filterRight.coefficients, newCoefficients);
-        }
-    }
-    else if (filterIndex == 4)
-    {
-        auto& filterLeft = leftChain.get<ChainPosition::filter4>();
-        auto& filterRight = rightChain.get<ChainPosition::filter4>();
-        
-        if (type == FilterType::lowCutType)
-        {
-            auto lowCutCoefficients = dsp::IIR::Coefficients<float>::makeHighPass (getSampleRate(), filter4Freq, filter4Q);
-            
-            updateCoefficients (filterLeft.coefficients, lowCutCoefficients);
-            updateCoefficients (filterRight.coefficients, lowCutCoefficients);
-        }
-        else if (type == FilterType::highCutType)
-        {
-            auto highCutCoefficients = dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), filter4Freq, filter4Q);
+void SimpleEQAudioProcessor::timerCallback()
+{
+    updateLinearPhase();
+    
+    const auto latency = getCurrentLatencySamples();
+    
+    if (latency != getLatencySamples())
+        setLatencySamples (latency);
+    
+    updateWorkerPool();
+}
 
-            updateCoefficients(filterLeft.coefficients, highCutCoefficients);
-            updateCoefficients(filterRight.coefficients, highCutCoefficients);
-        }
-        else if (type == FilterType::bellType)
-        {
-            auto newCoefficients = dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), filter4Freq, filter4Q, filter4Gain);
+void SimpleEQAudioProcessor::updateWorkerPool()
+{
+    workerPools.collectGarbage();
+    
+    // Worker threads only exist while they can be of use
+    const auto wanted = numPoolWorkers > 0 && multicoreParameter->load() >= 0.5f;
+    
+    if (wanted != (workerPools.get() != nullptr))
+        workerPools.set (wanted ? std::make_unique<Dsp::WorkerPool> (numPoolWorkers, poolBlockPeriodMs) : nullptr);
+}
 
-            updateCoefficients(filterLeft.coefficients, newCoefficients);
-            updateCoefficients(filterRight.coefficients, newCoefficients);
-        }
-        else if (type == FilterType::notchType)
-        {
-            auto newCoefficients = dsp::IIR::Coefficients<float>::makeNotch(getSampleRate(), filter4Freq, filter4Q);
+void SimpleEQAudioProcessor::followWorkerPool()
+{
+    if (workerPools.acquire())
+    {
+        floatChain.engine.setWorkerPool (workerPools.getAcquired());
+        doubleChain.engine.setWorkerPool (workerPools.getAcquired());
+    }
+}
 
-            updateCoefficients(filterLeft.coefficients, newCoefficients);
-            updateCoefficients(filterRight.coefficients, newCoefficients);
-        }
-        else if (type == FilterType::bandPassType)
-        {
-            auto newCoefficients = dsp::IIR::Coefficients<float>::makeBandPass(getSampleRate(), filter4Freq, filter4Q);
+void SimpleEQAudioProcessor::dropWorkerPools()
+{
+    floatChain.engine.setWorkerPool (nullptr);
+    doubleChain.engine.setWorkerPool (nullptr);
+    workerPools.clear();
+}
 
-            updateCoefficients(filterLeft.coefficients, newCoefficients);
-            updateCoefficients(filterRight.coefficients, newCoefficients);
-        }
+void SimpleEQAudioProcessor::updateLinearPhase()
+{
+    const auto quality = isLinearPhase() ? jlimit ((int) Dsp::LinearPhaseEQ::low, (int) Dsp::LinearPhaseEQ::high,
+                                                   (int) linearPhaseQualityParameter->load())
+                                         : -1;
+    
+    if (quality == linearPhase.getEnabledQuality())
+    {
+        linearPhase.collectGarbage();
     }
-    else if (filterIndex == 5)
+    else if (quality < 0)
     {
-        auto& filterLeft = leftChain.get<ChainPosition::filter5>();
-        auto& filterRight = rightChain.get<ChainPosition::filter5>();
+        linearPhase.disable();
+    }
+    else
+    {
+        // The first kernel is designed from the parameters; the audio thread hands its own
+        // setup over when it takes the convolvers on. Mid-transaction this waits a tick
+        Dsp::FilterSetup setup;
         
-        if (type == FilterType::lowCutType)
-        {
-            auto lowCutCoefficients = dsp::IIR::Coefficients<float>::makeHighPass (getSampleRate(), filter5Freq, filter5Q);
-            
-            updateCoefficients (filterLeft.coefficients, lowCutCoefficients);
-            updateCoefficients (filterRight.coefficients, lowCutCoefficients);
-        }
-        else if (type == FilterType::highCutType)
-        {
-            auto highCutCoefficients = dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), filter5Freq, filter5Q);
+        if (designPreviewSetup (setup, true))
+            linearPhase.enable (quality, setup);
+    }
+}
 
-            updateCoefficients(filterLeft.coefficients, highCutCoefficients);
-            updateCoefficients(filterRight.coefficients, highCutCoefficients);
-        }
-        else if (type == FilterType::bellType)
-        {
-            auto newCoefficients = dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), filter5Freq, filter5Q, filter5Gain);
+bool SimpleEQAudioProcessor::getLatestFilterSetup (Dsp::FilterSetup& destination)
+{
+    if (setupExchange.pull())
+    {
+        destination = setupExchange.getReadBuffer();
+        return true;
+    }
+    
+    // Nothing is published while processBlock isn't called (no audio device, or a host that
+    // stops processing with the transport), so the curve follows the parameters from here
+    return designPreviewSetup (destination, false);
+}
 
-            updateCoefficients(filterLeft.coefficients, newCoefficients);
-            updateCoefficients(filterRight.coefficients, newCoefficients);
-        }
-        else if (type == FilterType::notchType)
+bool SimpleEQAudioProcessor::designPreviewSetup (Dsp::FilterSetup& destination, bool forceAllBands) const
+{
+    AllBandValues values;
+    auto method = destination.method;
+    
+    // Mid-transaction the curve stays as it is until the next frame
+    if (! readParameterValues (values, method))
+        return false;
+    
+    // The rate the audio thread would design at; before the first prepareToPlay the
+    // previous one is as good as any
+    const auto hostRate = getSampleRate();
+    const auto oversampling = jlimit (0, Dsp::Oversampler<float>::maxFactorLog2, (int) oversamplingParameter->load());
+    const auto sampleRate = hostRate > 0.0 ? hostRate * (double) (1 << oversampling) : destination.sampleRate;
+    
+    const auto redesignAll = forceAllBands || method != destination.method || sampleRate != destination.sampleRate;
+    auto changed = redesignAll;
+    
+    for (size_t band = 0; band < values.size(); ++band)
+    {
+        const auto parameters = makeBandParameters (band, values[band]);
+        const auto bypassed = values[band][bypassValue] >= 0.5f;
+        auto& previous = destination.parameters[band];
+        
+        if (bypassed != destination.bypassed[band])
         {
-            auto newCoefficients = dsp::IIR::Coefficients<float>::makeNotch(getSampleRate(), filter5Freq, filter5Q);
-
-            updateCoefficients(filterLeft.coefficients, newCoefficients);
-            updateCoefficients(filterRight.coefficients, newCoefficients);
+            destination.bypassed[band] = bypassed;
+            changed = true;
         }
-        else if (type == FilterType::bandPassType)
+        
+        if (redesignAll || parameters.type != previous.type || parameters.frequency != previous.frequency
+             || parameters.q != previous.q || parameters.gain != previous.gain)
         {
-            auto newCoefficients = dsp::IIR::Coefficients<float>::makeBandPass(getSampleRate(), filter5Freq, filter5Q);
-
-            updateCoefficients(filterLeft.coefficients, newCoefficients);
-            updateCoefficients(filterRight.coefficients, newCoefficients);
+            previous = parameters;
+            Dsp::BiquadDesigner::design (previous, method, sampleRate, destination.coefficients[band]);
+            changed = true;
         }
     }
-    else if (filterIndex == 6)
-    {
-        auto& filterLeft = leftChain.get<ChainPosition::highCut>();
-        auto& filterRight = rightChain.get<ChainPosition::highCut>();
-        
-        auto highCutCoefficients = dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), highCutFreq, highCutQ);
+    
+    destination.method = method;
+    destination.sampleRate = sampleRate;
+    return changed;
+}
 
-        updateCoefficients(filterLeft.coefficients, highCutCoefficients);
-        updateCoefficients(filterRight.coefficients, highCutCoefficients);
-    }
+void SimpleEQAudioProcessor::publishFilterSetup()
+{
+    setupExchange.getWriteBuffer() = filterSetup;
+    setupExchange.publish();
 }
 
 //==============================================================================
@@ -10,12 +10,20 @@
 
 #include <JuceHeader.h>
 #include "PresetManager.h"
+#include "EQEngine.h"
+#include "Oversampler.h"
+#include "TripleBuffer.h"
+#include "WorkerPool.h"
+#include "ObjectHandoff.h"
+#include "LinearPhaseEQ.h"
+#include "SpectrumAnalyzer.h"
+#include "RealtimeAudit.h"
 
 //==============================================================================
 /**
 */
 class SimpleEQAudioProcessor  : public juce::AudioProcessor,
-public AudioProcessorValueTreeState::Listener
+                                private juce::Timer
 {
 public:
     //==============================================================================
@@ -31,6 +39,9 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -54,36 +65,68 @@ public:
     //==============================================================================
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
-    
-    void parameterChanged (const String &parameterID, float newValue) override;
 
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
     
     Service::PresetManager& getPresetManager() { return *presetManager; }
     
-    using Filter = juce::dsp::IIR::Filter<float>;
-    dsp::ProcessorChain<Filter, Filter, Filter, Filter, Filter, Filter> leftChain, rightChain;
+    /** Message thread only: copies the setup the audio thread applied most recently. While
+        the audio thread hasn't caught up with the parameters, e.g. because processBlock isn't
+        being called, a setup designed here from the parameters takes its place.
+        @returns true if destination changed.
+    */
+    bool getLatestFilterSetup (Dsp::FilterSetup& destination);
+    
+    /** Whether multicore processing is currently paying off; see Dsp::EQEngine. */
+    Dsp::MulticoreStatus getMulticoreStatus() const;
+    
+    /** Plain parameter values keyed by parameter ID. */
+    using ParameterValues = std::map<juce::String, float>;
+    
+    /** Applies a whole set of parameter values as one transaction. The audio thread keeps
+        the previous bands until every value is written, then redesigns each band that changed
+        once and switches to all of them together. Parameters not in the set keep their values;
+        host and editor are notified of each value that changed as usual.
+        Only one thread may apply a transaction at a time.
+    */
+    void applyParameterValues (const ParameterValues& values);
+    
+    /** The same for a state in the layout the presets use: PARAM children with "id" and "value". */
+    void applyParameterState (const juce::ValueTree& state);
     
-    enum FilterType
+    /** The memory of the six IIR bands on every channel, for checkpointing an offline render. */
+    struct FilterState
     {
-        lowCutType,
-        highCutType,
-        bellType,
-        notchType,
-        bandPassType
+        std::vector<double> values;
+        
+        /** Largest magnitude in the state; how loud the filters can still ring on silence. */
+        double getPeak() const noexcept
+        {
+            auto peak = 0.0;
+            
+            for (auto v : values)
+                peak = juce::jmax (peak, std::abs (v));
+            
+            return peak;
+        }
     };
     
-    float lowCutFreq = 100.0f, lowCutQ = 1.0f;
-    FilterType filter2Type = FilterType::bellType;
-    float filter2Freq = 200.0f, filter2Q = 0.707f, filter2Gain = 1.0f;
-    FilterType filter3Type = FilterType::bellType;
-    float filter3Freq = 400.0f, filter3Q = 0.707f, filter3Gain = 1.0f;
-    FilterType filter4Type = FilterType::bellType;
-    float filter4Freq = 800.0f, filter4Q = 0.707f, filter4Gain = 1.0f;
-    FilterType filter5Type = FilterType::bellType;
-    float filter5Freq = 1600.0f, filter5Q = 0.707f, filter5Gain = 1.0f;
-    float highCutFreq = 20000.0f, highCutQ = 1.0f;
+    /** True when the bands are the only memory the processing has, i.e. minimum phase without
+        oversampling. Only then does a saved FilterState describe the processor completely.
+    */
+    bool canCheckpointFilterState() const;
+    
+    /** Not while processing. Both work on whichever chain the next block will run through,
+        and restore only states saved with the same channel layout.
+    */
+    void saveFilterState (FilterState& destination) const;
+    void restoreFilterState (const FilterState& source);
+    
+    /** Pre / post EQ spectrum; idle until the editor enables it. */
+    Dsp::SpectrumAnalyzer& getSpectrumAnalyzer() noexcept { return spectrumAnalyzer; }
+    
+    using FilterType = Dsp::FilterType;
     
     enum ChainPosition
     {
@@ -95,16 +138,139 @@ public:
         highCut
     };
     
-    void updateCoefficients (Filter::CoefficientsPtr &old, const Filter::CoefficientsPtr &replacements)
+private:
+    
+    std::unique_ptr<Service::PresetManager> presetManager;
+    
+    void updateFilterSetup (bool forceAllBands);
+    void publishFilterSetup();
+    
+    static int getSmoothingBlockSize (int choiceIndex);
+    
+    bool isLinearPhase() const;
+    bool usesDoubleState() const;
+    int getCurrentLatencySamples() const;
+    
+    // Audio thread safe once prepared: the oversampler's buffers don't depend on the factor
+    void setOversampling (int index);
+    
+    /** The IIR engine and its oversampler in one sample type. There is one for float and one
+        for double, and both are kept prepared so either can take over without allocating.
+    */
+    template <typename SampleType>
+    struct ProcessingChain
     {
-        *old = *replacements;
-    }
+        Dsp::EQEngine<SampleType> engine;
+        Dsp::Oversampler<SampleType> oversampler;
+    };
     
-    void updateFilterSetup (int filterIndex, FilterType type, float freq, float Q, float gain);
+    template <typename SampleType>
+    void prepareChain (ProcessingChain<SampleType>& chain, int samplesPerBlock);
     
-private:
+    template <typename SampleType>
+    void processChain (ProcessingChain<SampleType>& chain, const juce::dsp::AudioBlock<SampleType>& block);
     
-    std::unique_ptr<Service::PresetManager> presetManager;
+    template <typename SampleType>
+    void processSamples (juce::AudioBuffer<SampleType>& buffer);
+    
+    // Latency has to be reported and worker threads started from the message thread, so mode
+    // changes are followed here
+    void timerCallback() override;
+    
+    // Raw parameter values, cached once so the audio thread can poll them without lookups
+    enum BandValue
+    {
+        bypassValue,
+        typeValue,
+        freqValue,
+        gainValue,
+        qValue,
+        numBandValues
+    };
+    
+    using BandValues = std::array<float, numBandValues>;
+    using AllBandValues = std::array<BandValues, Dsp::FilterSetup::numBands>;
+    
+    std::array<std::array<std::atomic<float>*, numBandValues>, Dsp::FilterSetup::numBands> bandParameters {};
+    std::atomic<float>* smoothingBlockParameter = nullptr;
+    std::atomic<float>* multicoreParameter = nullptr;
+    std::atomic<float>* phaseModeParameter = nullptr;
+    std::atomic<float>* linearPhaseQualityParameter = nullptr;
+    std::atomic<float>* oversamplingParameter = nullptr;
+    std::atomic<float>* designParameter = nullptr;
+    std::atomic<float>* precisionParameter = nullptr;
+    
+    // Audio thread: the values filterSetup was last designed from
+    AllBandValues appliedValues {};
+    
+    /** Any thread: every band value and the design method as one consistent set.
+        @returns false, leaving the arguments alone, if a transaction got in the way.
+    */
+    bool readParameterValues (AllBandValues& values, Dsp::DesignMethod& method) const;
+    
+    static Dsp::BandParameters makeBandParameters (size_t band, const BandValues& values);
+    
+    // Message thread: brings destination up to date with the parameters if it lags behind,
+    // or designs every band afresh
+    bool designPreviewSetup (Dsp::FilterSetup& destination, bool forceAllBands) const;
+    
+    // Worker threads, only while Multicore is on and the layout has more than one channel
+    // group. The message thread creates and drops pools, and the audio thread switches the
+    // engines over at the start of a block
+    void updateWorkerPool();
+    void followWorkerPool();
+    
+    // Only while nothing is processing
+    void dropWorkerPools();
+    
+    Dsp::ObjectHandoff<Dsp::WorkerPool> workerPools;
+    int numPoolWorkers = 0;
+    double poolBlockPeriodMs = 0.0;
+    
+    // Message thread: builds or drops the convolvers as the phase mode and quality change
+    void updateLinearPhase();
+    
+    ProcessingChain<float> floatChain;
+    ProcessingChain<double> doubleChain;
+    Dsp::LinearPhaseEQ linearPhase;
+    
+    // Float I/O with double state, and double I/O through the float only convolution
+    juce::AudioBuffer<double> doubleScratch;
+    juce::AudioBuffer<float> floatScratch;
+    
+    juce::dsp::ProcessSpec preparedSpec {};
+    double processingSampleRate = 44100.0;
+    int oversamplingIndex = 0;
+    bool linearPhaseWasActive = false, doubleStateWasActive = false;
+    Dsp::FilterSetup filterSetup;
+    
+    // Binary state: every parameter keyed by a hash of its ID
+    static constexpr int stateMagic = 0x53515a45;   // "EZQS"
+    static constexpr int stateFormatVersion = 1;
+    std::vector<juce::RangedAudioParameter*> stateParameters;
+    
+    // Key and index into stateParameters, sorted by key
+    using StateKeys = std::vector<std::pair<juce::uint32, size_t>>;
+    StateKeys stateKeys;
+    
+    // 32 bit FNV-1a of the UTF-8 ID, so saved states don't depend on how JUCE hashes strings
+    static juce::uint32 hashParameterID (const juce::String& parameterID);
+    
+    // The index of the parameter with the key, or -1 if there is none or more than one
+    static int findStateKey (const StateKeys& keys, juce::uint32 key);
+    
+    int findStateParameter (const juce::String& parameterID) const;
+    
+    // Normalised values in the order of stateParameters
+    void applyNormalisedValues (const std::vector<float>& values);
+    
+    // Odd while a transaction is writing parameters; the audio thread reads the band values
+    // like a seqlock and ignores anything read while this was odd or changed meanwhile
+    std::atomic<juce::uint32> transactionGeneration { 0 };
+    
+    // Audio thread -> editor
+    Dsp::TripleBuffer<Dsp::FilterSetup> setupExchange;
+    Dsp::SpectrumAnalyzer spectrumAnalyzer;
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEQAudioProcessor)
@@ -0,0 +1,208 @@
+#include "PresetLibrary.h"
+
+namespace Service
+{
+	File PresetLibrary::getDefaultDirectory()
+	{
+		return File::getSpecialLocation(File::SpecialLocationType::commonDocumentsDirectory)
+			.getChildFile(ProjectInfo::companyName)
+			.getChildFile(ProjectInfo::projectName);
+	}
+
+	PresetLibrary::PresetLibrary() :
+		Thread("Preset library"),
+		directory(getDefaultDirectory())
+	{
+		startThread(Thread::Priority::background);
+	}
+
+	PresetLibrary::~PresetLibrary()
+	{
+		stopThread(2000);
+	}
+
+	StringArray PresetLibrary::getNames() const
+	{
+		const ScopedLock sl(lock);
+		return names;
+	}
+
+	int PresetLibrary::size() const
+	{
+		const ScopedLock sl(lock);
+		return names.size();
+	}
+
+	int PresetLibrary::indexOf(const String& presetName) const
+	{
+		const ScopedLock sl(lock);
+		return names.indexOf(presetName);
+	}
+
+	String PresetLibrary::getName(int index) const
+	{
+		const ScopedLock sl(lock);
+		return names[index];
+	}
+
+	ValueTree PresetLibrary::getCachedPreset(const String& presetName) const
+	{
+		// One stat, so a preset overwritten behind our back is never served stale
+		const auto modificationTime = directory.getChildFile(presetName + "." + extension).getLastModificationTime();
+
+		const ScopedLock sl(lock);
+		const auto found = cache.find(presetName);
+
+		if (found == cache.end() || found->second.modificationTime != modificationTime)
+			return {};
+
+		return found->second.tree;
+	}
+
+	void PresetLibrary::requestPreset(const String& presetName, LoadCallback callback)
+	{
+		{
+			const ScopedLock sl(lock);
+			callbacks.emplace(presetName, std::move(callback));
+			pendingNames.addIfNotAlreadyThere(presetName);
+		}
+
+		notify();
+	}
+
+	void PresetLibrary::prefetchAround(int index)
+	{
+		{
+			const ScopedLock sl(lock);
+
+			if (names.isEmpty())
+				return;
+
+			StringArray wanted;
+
+			for (int offset = -prefetchRadius; offset <= prefetchRadius; ++offset)
+				wanted.add(names[(index + offset + names.size() * prefetchRadius) % names.size()]);
+
+			for (auto it = cache.begin(); it != cache.end();)
+				it = wanted.contains(it->first) ? std::next(it) : cache.erase(it);
+
+			for (const auto& name : wanted)
+				if (cache.find(name) == cache.end())
+					pendingNames.addIfNotAlreadyThere(name);
+		}
+
+		notify();
+	}
+
+	void PresetLibrary::presetWritten(const File& presetFile)
+	{
+		{
+			const ScopedLock sl(lock);
+			names.addIfNotAlreadyThere(presetFile.getFileNameWithoutExtension());
+			names.sortNatural();
+			cache.erase(presetFile.getFileNameWithoutExtension());
+		}
+
+		sendChangeMessage();
+	}
+
+	void PresetLibrary::presetDeleted(const String& presetName)
+	{
+		{
+			const ScopedLock sl(lock);
+			names.removeString(presetName);
+			cache.erase(presetName);
+		}
+
+		sendChangeMessage();
+	}
+
+	void PresetLibrary::run()
+	{
+		while (!threadShouldExit())
+		{
+			// Adding, removing or renaming a file touches the directory itself
+			const auto modificationTime = directory.getLastModificationTime();
+
+			if (modificationTime != directoryModificationTime)
+			{
+				directoryModificationTime = modificationTime;
+				rescan();
+			}
+
+			parsePending();
+			wait(pollIntervalMs);
+		}
+	}
+
+	void PresetLibrary::rescan()
+	{
+		StringArray scanned;
+
+		for (const auto& entry : RangedDirectoryIterator(directory, false, String("*.") + extension, File::findFiles))
+			scanned.add(entry.getFile().getFileNameWithoutExtension());
+
+		scanned.sortNatural();
+
+		{
+			const ScopedLock sl(lock);
+
+			if (scanned == names)
+				return;
+
+			names.swapWith(scanned);
+		}
+
+		sendChangeMessage();
+	}
+
+	void PresetLibrary::parsePending()
+	{
+		for (;;)
+		{
+			String presetName;
+
+			{
+				const ScopedLock sl(lock);
+
+				if (pendingNames.isEmpty())
+					return;
+
+				presetName = pendingNames[0];
+				pendingNames.remove(0);
+			}
+
+			// The disk access and the parsing happen outside the lock
+			const auto presetFile = directory.getChildFile(presetName + "." + extension);
+			CachedPreset parsed{ presetFile.getLastModificationTime(), {} };
+
+			if (auto xml = XmlDocument::parse(presetFile))
+				parsed.tree = ValueTree::fromXml(*xml);
+
+			std::vector<LoadCallback> waiting;
+
+			{
+				const ScopedLock sl(lock);
+
+				if (parsed.tree.isValid())
+					cache[presetName] = parsed;
+
+				const auto range = callbacks.equal_range(presetName);
+
+				for (auto it = range.first; it != range.second; ++it)
+					waiting.push_back(std::move(it->second));
+
+				callbacks.erase(range.first, range.second);
+			}
+
+			for (auto& callback : waiting)
+				MessageManager::callAsync([callback = std::move(callback), presetName, tree = parsed.tree]
+					{
+						callback(presetName, tree);
+					});
+
+			if (threadShouldExit())
+				return;
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Service
+{
+	/**
+		An in-memory index of the preset directory and a cache of parsed presets, shared by
+		every instance in the process.
+
+		A background thread scans the directory, notices changes to it by polling its
+		modification time and parses presets ahead of time. Asking for a preset that is
+		already parsed costs nothing; anything else is parsed on that thread and handed back
+		on the message thread. The neighbours of the preset in use are prefetched, so stepping
+		through the library doesn't touch the disk on the message thread at all.
+
+		Index changes are announced as change messages.
+	*/
+	class PresetLibrary : public ChangeBroadcaster,
+		private Thread
+	{
+	public:
+		using LoadCallback = std::function<void(const String& presetName, const ValueTree& preset)>;
+
+		static File getDefaultDirectory();
+		static constexpr const char* extension = "preset";
+
+		PresetLibrary();
+		~PresetLibrary() override;
+
+		/** Sorted preset names, as of the last scan. */
+		StringArray getNames() const;
+		int size() const;
+		int indexOf(const String& presetName) const;
+		String getName(int index) const;
+
+		/** Returns the parsed preset if it is cached and its file hasn't changed since, or an
+			invalid tree otherwise.
+		*/
+		ValueTree getCachedPreset(const String& presetName) const;
+
+		/** Parses the preset on the library thread and calls back on the message thread. */
+		void requestPreset(const String& presetName, LoadCallback callback);
+
+		/** Keeps the presets around this index parsed and drops the rest of the cache. */
+		void prefetchAround(int index);
+
+		/** Our own writes show up in the index straight away instead of at the next scan. */
+		void presetWritten(const File& presetFile);
+		void presetDeleted(const String& presetName);
+
+	private:
+		struct CachedPreset
+		{
+			Time modificationTime;
+			ValueTree tree;
+		};
+
+		void run() override;
+		void rescan();
+		void parsePending();
+
+		static constexpr int pollIntervalMs = 1000;
+		static constexpr int prefetchRadius = 2;
+
+		const File directory;
+		Time directoryModificationTime;
+
+		mutable CriticalSection lock;
+		StringArray names;
+		std::map<String, CachedPreset> cache;
+		StringArray pendingNames;
+		std::multimap<String, LoadCallback> callbacks;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetLibrary)
+	};
+}
@@ -2,16 +2,13 @@
 
 namespace Service
 {
-	const File PresetManager::defaultDirectory{ File::getSpecialLocation(
-		File::SpecialLocationType::commonDocumentsDirectory)
-			.getChildFile(ProjectInfo::companyName)
-			.getChildFile(ProjectInfo::projectName)
-	};
-	const String PresetManager::extension{ "preset" };
+	const File PresetManager::defaultDirectory{ PresetLibrary::getDefaultDirectory() };
+	const String PresetManager::extension{ PresetLibrary::extension };
 	const String PresetManager::presetNameProperty{ "presetName" };
 
-	PresetManager::PresetManager(AudioProcessorValueTreeState& apvts) :
-		valueTreeState(apvts)
+	PresetManager::PresetManager(AudioProcessorValueTreeState& apvts, ParameterApplier applyParameters) :
+		valueTreeState(apvts),
+		parameterApplier(std::move(applyParameters))
 	{
 		// Create a default Preset Directory, if it doesn't exist
 		if (!defaultDirectory.exists())
@@ -40,7 +37,9 @@ namespace Service
 		{
 			DBG("Could not create preset file: " + presetFile.getFullPathName());
 			jassertfalse;
+			return;
 		}
+		library->presetWritten(presetFile);
 	}
 
 	void PresetManager::deletePreset(const String& presetName)
@@ -61,7 +60,9 @@ namespace Service
 			jassertfalse;
 			return;
 		}
+		library->presetDeleted(presetName);
 		currentPreset.setValue("");
+		requestedPreset.clear();
 	}
 
 	void PresetManager::loadPreset(const String& presetName)
@@ -69,54 +70,70 @@ namespace Service
 		if (presetName.isEmpty())
 			return;
 
-		const auto presetFile = defaultDirectory.getChildFile(presetName + "." + extension);
-		if (!presetFile.existsAsFile())
+		requestedPreset = presetName;
+		library->prefetchAround(library->indexOf(presetName));
+
+		// Prefetched presets apply straight away; anything else is parsed off the message thread
+		if (const auto cached = library->getCachedPreset(presetName); cached.isValid())
 		{
-			DBG("Preset file " + presetFile.getFullPathName() + " does not exist");
+			applyPreset(presetName, cached);
+			return;
+		}
+
+		library->requestPreset(presetName, [weakThis = WeakReference<PresetManager>(this)](const String& name, const ValueTree& preset)
+			{
+				if (weakThis != nullptr && weakThis->requestedPreset == name)
+					weakThis->applyPreset(name, preset);
+			});
+	}
+
+	void PresetManager::applyPreset(const String& presetName, const ValueTree& preset)
+	{
+		if (!preset.isValid())
+		{
+			DBG("Preset " + presetName + " could not be read");
 			jassertfalse;
 			return;
 		}
-		// presetFile (XML) -> (ValueTree)
-		XmlDocument xmlDocument{ presetFile };
-		const auto valueTreeToLoad = ValueTree::fromXml(*xmlDocument.getDocumentElement());
 
-		valueTreeState.replaceState(valueTreeToLoad);
+		// All values in one transaction instead of replaceState's one update per parameter; the
+		// cached tree is only read
+		parameterApplier(preset);
 		currentPreset.setValue(presetName);
-
+		requestedPreset.clear();
 	}
 
 	int PresetManager::loadNextPreset()
 	{
-		const auto allPresets = getAllPresets();
-		if (allPresets.isEmpty())
+		const auto numPresets = library->size();
+		if (numPresets == 0)
 			return -1;
-		const auto currentIndex = allPresets.indexOf(currentPreset.toString());
-		const auto nextIndex = currentIndex + 1 > (allPresets.size() - 1) ? 0 : currentIndex + 1;
-		loadPreset(allPresets.getReference(nextIndex));
+		const auto currentIndex = library->indexOf(getNavigationPreset());
+		const auto nextIndex = currentIndex + 1 > (numPresets - 1) ? 0 : currentIndex + 1;
+		loadPreset(library->getName(nextIndex));
 		return nextIndex;
 	}
 
 	int PresetManager::loadPreviousPreset()
 	{
-		const auto allPresets = getAllPresets();
-		if (allPresets.isEmpty())
+		const auto numPresets = library->size();
+		if (numPresets == 0)
 			return -1;
-		const auto currentIndex = allPresets.indexOf(currentPreset.toString());
-		const auto previousIndex = currentIndex - 1 < 0 ? allPresets.size() - 1 : currentIndex - 1;
-		loadPreset(allPresets.getReference(previousIndex));
+		const auto currentIndex = library->indexOf(getNavigationPreset());
+		const auto previousIndex = currentIndex - 1 < 0 ? numPresets - 1 : currentIndex - 1;
+		loadPreset(library->getName(previousIndex));
 		return previousIndex;
 	}
 
 	StringArray PresetManager::getAllPresets() const
 	{
-		StringArray presets;
-		const auto fileArray = defaultDirectory.findChildFiles(
-			File::TypesOfFileToFind::findFiles, false, "*." + extension);
-		for (const auto& file : fileArray)
-		{
-			presets.add(file.getFileNameWithoutExtension());
-		}
-		return presets;
+		return library->getNames();
+	}
+
+	String PresetManager::getNavigationPreset() const
+	{
+		// Stepping again before the last preset has arrived moves on from that one
+		return requestedPreset.isNotEmpty() ? requestedPreset : currentPreset.toString();
 	}
 
 	String PresetManager::getCurrentPreset() const
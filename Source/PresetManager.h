@@ -1,6 +1,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "PresetLibrary.h"
 
 namespace Service
 {
@@ -11,7 +12,12 @@ namespace Service
 		static const String extension;
 		static const String presetNameProperty;
 
-		PresetManager(AudioProcessorValueTreeState&);
+		/** Presets are applied through applyParameters, so the processor can take all of a
+			preset's values in one transaction.
+		*/
+		using ParameterApplier = std::function<void(const ValueTree& state)>;
+
+		PresetManager(AudioProcessorValueTreeState&, ParameterApplier applyParameters);
 
 		void savePreset(const String& presetName);
 		void deletePreset(const String& presetName);
@@ -20,10 +26,23 @@ namespace Service
 		int loadPreviousPreset();
 		StringArray getAllPresets() const;
 		String getCurrentPreset() const;
+
+		PresetLibrary& getLibrary() { return *library; }
 	private:
 		void valueTreeRedirected(ValueTree& treeWhichHasBeenChanged) override;
+		void applyPreset(const String& presetName, const ValueTree& preset);
+		String getNavigationPreset() const;
 
 		AudioProcessorValueTreeState& valueTreeState;
+		ParameterApplier parameterApplier;
 		Value currentPreset;
+
+		// Shared by all instances: one index, one cache, one thread
+		SharedResourcePointer<PresetLibrary> library;
+
+		// The preset asked for last; an older one that finishes parsing later is not applied
+		String requestedPreset;
+
+		JUCE_DECLARE_WEAK_REFERENCEABLE(PresetManager)
 	};
 }
\ No newline at end of file
@@ -55,7 +55,7 @@ namespace Gui
 	};
 
 
-	class PresetPanel : public Component, Button::Listener, ComboBox::Listener
+	class PresetPanel : public Component, Button::Listener, ComboBox::Listener, ChangeListener
 	{
 	public:
 		PresetPanel(Service::PresetManager& pm) : presetManager(pm)
@@ -76,10 +76,13 @@ namespace Gui
 			presetList.addListener(this);
 
 			loadPresetList();
+			presetManager.getLibrary().addChangeListener(this);
 		}
 
 		~PresetPanel()
 		{
+			presetManager.getLibrary().removeChangeListener(this);
+
             presetList.setLookAndFeel (nullptr);
             
             saveButton.setLookAndFeel (nullptr);
@@ -146,6 +149,12 @@ namespace Gui
 			}
 		}
 
+		// The library was rescanned or changed on disk
+		void changeListenerCallback(ChangeBroadcaster*) override
+		{
+			loadPresetList();
+		}
+
 		void configureButton(TextButton& button, const String& buttonText)
 		{
 			button.setButtonText(buttonText);
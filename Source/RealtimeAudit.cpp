@@ -0,0 +1,253 @@
+/*
+  ==============================================================================
+
+    RealtimeAudit.cpp
+    Records allocations, locks and blocking calls made on the audio thread.
+
+  ==============================================================================
+*/
+
+#include "RealtimeAudit.h"
+
+#if EZEQ_REALTIME_AUDIT
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+ #include <dbghelp.h>
+ #pragma comment (lib, "dbghelp.lib")
+#else
+ #include <execinfo.h>
+ #include <cxxabi.h>
+#endif
+
+namespace Dsp
+{
+    namespace RealtimeAudit
+    {
+        namespace
+        {
+            constexpr int maxFrames = 32, maxSites = 256;
+
+            // One distinct call site. The key is claimed first, the stack filled in and only
+            // then is the site marked ready for the report
+            struct Site
+            {
+                std::atomic<uint64> key { 0 };
+                std::atomic<bool> ready { false };
+                std::atomic<int> count { 0 };
+                Violation type = allocation;
+                std::array<void*, maxFrames> frames {};
+                int numFrames = 0;
+            };
+
+            std::array<std::atomic<int>, numViolations> counts {};
+            std::array<Site, maxSites> sites;
+            std::atomic<int> numDroppedSites { 0 };
+
+            thread_local bool onAudioThread = false;
+            thread_local bool isRecording = false;
+
+            int captureStack (void** frames, int maxToCapture) noexcept
+            {
+               #if JUCE_WINDOWS
+                return (int) CaptureStackBackTrace (0, (DWORD) maxToCapture, frames, nullptr);
+               #else
+                return backtrace (frames, maxToCapture);
+               #endif
+            }
+
+            uint64 hashStack (Violation type, void* const* frames, int numFrames) noexcept
+            {
+                auto hash = (uint64) 14695981039346656037ull ^ (uint64) type;
+
+                for (int i = 0; i < numFrames; ++i)
+                    hash = (hash ^ (uint64) (pointer_sized_uint) frames[i]) * (uint64) 1099511628211ull;
+
+                return hash != 0 ? hash : 1;
+            }
+
+            // The unwinder loads its support library on first use, which allocates; better
+            // during start up than on the audio thread
+            const int unwinderPrimed = []
+            {
+                void* frames[4];
+                return captureStack (frames, 4);
+            }();
+
+            String symbolise (void* const* frames, int numFrames)
+            {
+                String result;
+
+               #if JUCE_WINDOWS
+                const auto process = GetCurrentProcess();
+                static const auto symbolsLoaded = SymInitialize (process, nullptr, TRUE);
+
+                alignas (SYMBOL_INFO) char buffer[sizeof (SYMBOL_INFO) + 256] {};
+                auto* symbol = reinterpret_cast<SYMBOL_INFO*> (buffer);
+
+                for (int i = 0; i < numFrames; ++i)
+                {
+                    symbol->SizeOfStruct = sizeof (SYMBOL_INFO);
+                    symbol->MaxNameLen = 255;
+                    DWORD64 displacement = 0;
+
+                    result << "    ";
+
+                    if (symbolsLoaded && SymFromAddr (process, (DWORD64) frames[i], &displacement, symbol))
+                        result << symbol->Name << " + " << (int) displacement;
+                    else
+                        result << "0x" << String::toHexString ((pointer_sized_int) frames[i]);
+
+                    result << newLine;
+                }
+               #else
+                if (auto* symbols = backtrace_symbols (frames, numFrames))
+                {
+                    for (int i = 0; i < numFrames; ++i)
+                    {
+                        // "image(symbol+offset) [address]" on Linux, "index image address symbol + offset" on macOS
+                        String line (symbols[i]);
+                        const auto mangled = line.contains ("(") ? line.fromFirstOccurrenceOf ("(", false, false).upToFirstOccurrenceOf ("+", false, false)
+                                                                 : line.fromLastOccurrenceOf (" 0x", false, false).fromFirstOccurrenceOf (" ", false, false)
+                                                                                                                 .upToFirstOccurrenceOf (" ", false, false);
+                        auto status = -1;
+
+                        if (auto* demangled = abi::__cxa_demangle (mangled.toRawUTF8(), nullptr, nullptr, &status))
+                        {
+                            if (status == 0)
+                                line = line.replace (mangled, demangled);
+
+                            ::free (demangled);
+                        }
+
+                        result << "    " << line << newLine;
+                    }
+
+                    ::free (symbols);
+                }
+               #endif
+
+                return result;
+            }
+        }
+
+        //==============================================================================
+        ScopedAudioThread::ScopedAudioThread() noexcept
+            : wasAudioThread (onAudioThread)
+        {
+            onAudioThread = true;
+        }
+
+        ScopedAudioThread::~ScopedAudioThread() noexcept
+        {
+            onAudioThread = wasAudioThread;
+        }
+
+        void reportViolation (Violation type) noexcept
+        {
+            // Taking the stack may come back through the hooks
+            if (! onAudioThread || isRecording)
+                return;
+
+            isRecording = true;
+            counts[(size_t) type].fetch_add (1, std::memory_order_relaxed);
+
+            std::array<void*, maxFrames> frames;
+            const auto numFrames = captureStack (frames.data(), maxFrames);
+            const auto key = hashStack (type, frames.data(), numFrames);
+
+            auto recorded = false;
+
+            for (int probe = 0; probe < maxSites && ! recorded; ++probe)
+            {
+                auto& site = sites[(size_t) ((key + (uint64) probe) % (uint64) maxSites)];
+                auto existing = site.key.load (std::memory_order_acquire);
+
+                if (existing == 0 && site.key.compare_exchange_strong (existing, key, std::memory_order_acq_rel))
+                {
+                    site.type = type;
+                    site.frames = frames;
+                    site.numFrames = numFrames;
+                    site.ready.store (true, std::memory_order_release);
+                    existing = key;
+                }
+
+                if (existing == key)
+                {
+                    site.count.fetch_add (1, std::memory_order_relaxed);
+                    recorded = true;
+                }
+            }
+
+            if (! recorded)
+                numDroppedSites.fetch_add (1, std::memory_order_relaxed);
+
+            isRecording = false;
+        }
+
+        int getNumViolations (Violation type) noexcept
+        {
+            return counts[(size_t) type].load();
+        }
+
+        int getTotalViolations() noexcept
+        {
+            auto total = 0;
+
+            for (auto& count : counts)
+                total += count.load();
+
+            return total;
+        }
+
+        String getReport()
+        {
+            String report;
+
+            for (auto& site : sites)
+            {
+                if (! site.ready.load (std::memory_order_acquire))
+                    continue;
+
+                report << getViolationName (site.type) << ", " << site.count.load() << " times at:" << newLine
+                       << symbolise (site.frames.data(), site.numFrames) << newLine;
+            }
+
+            if (const auto dropped = numDroppedSites.load(); dropped > 0)
+                report << dropped << " more calls from call sites that did not fit the table" << newLine;
+
+            return report;
+        }
+
+        void reset() noexcept
+        {
+            for (auto& count : counts)
+                count.store (0);
+
+            for (auto& site : sites)
+            {
+                site.ready.store (false);
+                site.count.store (0);
+                site.key.store (0);
+            }
+
+            numDroppedSites.store (0);
+        }
+
+        String getViolationName (Violation type)
+        {
+            switch (type)
+            {
+                case allocation:    return "allocation";
+                case deallocation:  return "deallocation";
+                case mutexLock:     return "mutex lock";
+                case blockingCall:  return "blocking call";
+                case numViolations: break;
+            }
+
+            return {};
+        }
+    }
+}
+
+#endif
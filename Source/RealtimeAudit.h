@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    RealtimeAudit.h
+    Records allocations, locks and blocking calls made on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Off unless the build asks for it (the benchmark tool's Audit configuration); the thread
+// marks below then compile to nothing
+#ifndef EZEQ_REALTIME_AUDIT
+ #define EZEQ_REALTIME_AUDIT 0
+#endif
+
+namespace Dsp
+{
+    /**
+        Real-time safety audit of the audio thread.
+
+        processBlock and the worker pool's jobs mark their thread as an audio thread while they
+        run. Hooks on the allocator, on locks and on blocking system calls report every call to
+        reportViolation(), which ignores unmarked threads. For marked ones it counts the call
+        and keeps its stack, one record per distinct call site. Recording never allocates,
+        locks or blocks, so the hooks may call it from anywhere.
+
+        The hooks themselves belong to the executable that hosts the processor, because
+        replacing malloc or pthread_mutex_lock from inside a plugin would affect the whole
+        host process. The benchmark tool has them in AuditHooks.cpp.
+    */
+    namespace RealtimeAudit
+    {
+        enum Violation
+        {
+            allocation,
+            deallocation,
+            mutexLock,
+            blockingCall,
+            numViolations
+        };
+
+       #if EZEQ_REALTIME_AUDIT
+        /** Marks the calling thread as an audio thread while in scope. Scopes may nest. */
+        class ScopedAudioThread
+        {
+        public:
+            ScopedAudioThread() noexcept;
+            ~ScopedAudioThread() noexcept;
+
+        private:
+            bool wasAudioThread;
+
+            JUCE_DECLARE_NON_COPYABLE (ScopedAudioThread)
+        };
+
+        /** Any thread: counts and records the call if the thread is marked; never allocates. */
+        void reportViolation (Violation type) noexcept;
+
+        int getNumViolations (Violation type) noexcept;
+        int getTotalViolations() noexcept;
+
+        /** Each call site with its count and stack, symbolised; allocates, so not on the audio thread. */
+        String getReport();
+
+        /** Clears the counts and records; only while no marked thread is running. */
+        void reset() noexcept;
+
+        String getViolationName (Violation type);
+       #else
+        struct ScopedAudioThread
+        {
+            ScopedAudioThread() noexcept {}
+        };
+       #endif
+    }
+}
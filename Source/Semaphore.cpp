@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    Semaphore.cpp
+    Counting semaphore that can be posted from the audio thread.
+
+  ==============================================================================
+*/
+
+#include "Semaphore.h"
+
+#if JUCE_MAC || JUCE_IOS
+ #include <mach/mach.h>
+#elif JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <semaphore.h>
+ #include <cerrno>
+#endif
+
+namespace Dsp
+{
+    struct Semaphore::Impl
+    {
+        Impl()
+        {
+           #if JUCE_MAC || JUCE_IOS
+            semaphore_create (mach_task_self(), &semaphore, SYNC_POLICY_FIFO, 0);
+           #elif JUCE_WINDOWS
+            semaphore = CreateSemaphore (nullptr, 0, LONG_MAX, nullptr);
+           #else
+            sem_init (&semaphore, 0, 0);
+           #endif
+        }
+
+        ~Impl()
+        {
+           #if JUCE_MAC || JUCE_IOS
+            semaphore_destroy (mach_task_self(), semaphore);
+           #elif JUCE_WINDOWS
+            CloseHandle (semaphore);
+           #else
+            sem_destroy (&semaphore);
+           #endif
+        }
+
+       #if JUCE_MAC || JUCE_IOS
+        semaphore_t semaphore {};
+       #elif JUCE_WINDOWS
+        HANDLE semaphore = nullptr;
+       #else
+        sem_t semaphore {};
+       #endif
+    };
+
+    //==============================================================================
+    Semaphore::Semaphore()
+        : impl (std::make_unique<Impl>())
+    {
+    }
+
+    Semaphore::~Semaphore() = default;
+
+    void Semaphore::post() noexcept
+    {
+       #if JUCE_MAC || JUCE_IOS
+        semaphore_signal (impl->semaphore);
+       #elif JUCE_WINDOWS
+        ReleaseSemaphore (impl->semaphore, 1, nullptr);
+       #else
+        sem_post (&impl->semaphore);
+       #endif
+    }
+
+    void Semaphore::wait() noexcept
+    {
+       #if JUCE_MAC || JUCE_IOS
+        semaphore_wait (impl->semaphore);
+       #elif JUCE_WINDOWS
+        WaitForSingleObject (impl->semaphore, INFINITE);
+       #else
+        while (sem_wait (&impl->semaphore) != 0 && errno == EINTR) {}
+       #endif
+    }
+}
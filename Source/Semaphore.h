@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+
+    Semaphore.h
+    Counting semaphore that can be posted from the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp
+{
+    /**
+        Counting semaphore straight on the OS primitive: a futex based sem_t on Linux, a Mach
+        semaphore on macOS and a kernel semaphore on Windows.
+
+        Unlike WaitableEvent, whose signal() takes a mutex the waiting thread may be holding,
+        post() never locks, so the audio thread may wake a helper thread with it. It still
+        enters the kernel when somebody is asleep, so it belongs on changes rather than on
+        every block where that can be avoided.
+    */
+    class Semaphore
+    {
+    public:
+        Semaphore();
+        ~Semaphore();
+
+        void post() noexcept;
+
+        /** Blocks until a post is available and takes it. */
+        void wait() noexcept;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl;
+
+        JUCE_DECLARE_NON_COPYABLE (Semaphore)
+    };
+}
@@ -0,0 +1,362 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.cpp
+    Pre / post EQ spectrum, analysed away from the audio thread.
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+
+namespace Dsp
+{
+    namespace
+    {
+        // Hann window with 75% overlap: every sample contributes to four frames
+        constexpr int overlapFactor = 4;
+
+        // Level ballistics in seconds; the peak holds for a moment and then falls in dB per second
+        constexpr float attackSeconds = 0.02f, releaseSeconds = 0.3f;
+        constexpr float peakHoldSeconds = 1.0f, peakFallDecibelsPerSecond = 20.0f;
+
+        // Room for several frames of history, so a late wake-up of the analysis thread only
+        // costs frames when it's very late
+        constexpr int fifoFramesOfHistory = 8;
+
+        int getFftOrder (double sampleRate) noexcept
+        {
+            // 4096 points at 48 kHz; scaled with the rate so the resolution in Hz stays the same
+            const auto rateFactor = jmax (1, nextPowerOfTwo (roundToInt (sampleRate / 48000.0)));
+            return 12 + roundToInt (std::log2 ((double) rateFactor));
+        }
+    }
+
+    //==============================================================================
+    class SpectrumAnalyzer::AnalysisThread  : public Thread
+    {
+    public:
+        AnalysisThread (SpectrumAnalyzer& ownerToUse, double sampleRate)
+            : Thread ("EQ spectrum analyzer"),
+              owner (ownerToUse),
+              fft (getFftOrder (sampleRate)),
+              fftSize (fft.getSize()),
+              hopSize (fftSize / overlapFactor),
+              window ((size_t) fftSize),
+              fftData ((size_t) fftSize * 2)
+        {
+            dsp::WindowingFunction<float>::fillWindowingTables (window.data(), window.size(),
+                                                                dsp::WindowingFunction<float>::hann, false);
+
+            // A full scale sine reads 0 dBFS: the Hann window passes half its amplitude and
+            // the real FFT spreads the rest over fftSize / 2 bins
+            const auto amplitudeScale = 1.0f / ((float) fftSize * 0.25f);
+            decibelOffset = Decibels::gainToDecibels (amplitudeScale, -1000.0f);
+
+            const auto hopSeconds = (float) hopSize / (float) sampleRate;
+            attackCoefficient = std::exp (-hopSeconds / attackSeconds);
+            releaseCoefficient = std::exp (-hopSeconds / releaseSeconds);
+            peakHoldFrames = roundToInt (peakHoldSeconds / hopSeconds);
+            peakFallPerFrame = peakFallDecibelsPerSecond * hopSeconds;
+
+            buildGrid (sampleRate);
+
+            for (auto& state : tapStates)
+                state.history.resize ((size_t) fftSize, 0.0f);
+
+            clearLevels();
+        }
+
+        void run() override
+        {
+            auto wasEnabled = false;
+
+            while (! threadShouldExit())
+            {
+                // Asleep until setEnabled (true) or stopThread() wakes it
+                if (! owner.isEnabled())
+                {
+                    wasEnabled = false;
+                    wait (-1);
+                    continue;
+                }
+
+                // Whatever is queued is left over from the last time the analyzer was on
+                if (! wasEnabled)
+                {
+                    for (auto& tap : owner.taps)
+                        discard (tap.fifo, tap.fifo.getNumReady());
+
+                    clearLevels();
+                    wasEnabled = true;
+                }
+
+                // While on, polled rather than signalled, so the audio thread never makes a
+                // system call; this is about the rate a display can use anyway
+                wait (15);
+
+                auto anyNewFrame = false;
+
+                for (int tap = 0; tap < numTaps; ++tap)
+                    anyNewFrame = analyseTap (tap) || anyNewFrame;
+
+                if (anyNewFrame)
+                    publish();
+            }
+        }
+
+    private:
+        struct TapState
+        {
+            std::vector<float> history;
+            std::array<float, numPoints> level {}, peak {};
+            std::array<int, numPoints> peakAge {};
+        };
+
+        // FFT bins [firstBin, lastBin] fold into one grid point; where the grid is finer than
+        // the bins it interpolates between firstBin and firstBin + 1 instead
+        struct GridPoint
+        {
+            int firstBin = 0, lastBin = 0;
+            float fraction = 0.0f;
+        };
+
+        void buildGrid (double sampleRate)
+        {
+            const auto binsPerHz = (double) fftSize / sampleRate;
+            const auto maxBin = fftSize / 2;
+            const auto ratio = std::pow ((double) maxFrequency / (double) minFrequency, 1.0 / (numPoints - 1));
+
+            for (int i = 0; i < numPoints; ++i)
+            {
+                const auto centre = (double) minFrequency * std::pow (ratio, (double) i);
+                const auto low = centre / std::sqrt (ratio) * binsPerHz;
+                const auto high = centre * std::sqrt (ratio) * binsPerHz;
+
+                auto& point = grid[(size_t) i];
+                point.firstBin = jlimit (0, maxBin, (int) std::ceil (low));
+                point.lastBin = jlimit (0, maxBin, (int) std::floor (high));
+
+                if (point.lastBin < point.firstBin)
+                {
+                    const auto bin = jlimit (0.0, (double) maxBin - 1, centre * binsPerHz);
+                    point.firstBin = point.lastBin = (int) bin;
+                    point.fraction = (float) (bin - std::floor (bin));
+                }
+            }
+        }
+
+        void clearLevels()
+        {
+            for (auto& state : tapStates)
+            {
+                std::fill (state.history.begin(), state.history.end(), 0.0f);
+                state.level.fill (floorDecibels);
+                state.peak.fill (floorDecibels);
+                state.peakAge.fill (0);
+            }
+        }
+
+        static void discard (AbstractFifo& fifo, int numToDiscard)
+        {
+            const auto scope = fifo.read (numToDiscard);
+            ignoreUnused (scope);
+        }
+
+        bool analyseTap (int tapIndex)
+        {
+            auto& tap = owner.taps[(size_t) tapIndex];
+            auto& state = tapStates[(size_t) tapIndex];
+
+            // After a stall, skip straight to the most recent window instead of catching up
+            const auto ready = tap.fifo.getNumReady();
+
+            if (ready > fftSize)
+                discard (tap.fifo, ready - fftSize);
+
+            auto anyFrame = false;
+
+            while (tap.fifo.getNumReady() >= hopSize)
+            {
+                std::move (state.history.begin() + hopSize, state.history.end(), state.history.begin());
+
+                auto* destination = state.history.data() + (fftSize - hopSize);
+                const auto scope = tap.fifo.read (hopSize);
+
+                if (scope.blockSize1 > 0)
+                    FloatVectorOperations::copy (destination, tap.samples.data() + scope.startIndex1, scope.blockSize1);
+
+                if (scope.blockSize2 > 0)
+                    FloatVectorOperations::copy (destination + scope.blockSize1, tap.samples.data() + scope.startIndex2, scope.blockSize2);
+
+                analyseFrame (state);
+                anyFrame = true;
+            }
+
+            return anyFrame;
+        }
+
+        void analyseFrame (TapState& state)
+        {
+            FloatVectorOperations::multiply (fftData.data(), state.history.data(), window.data(), fftSize);
+            std::fill (fftData.begin() + fftSize, fftData.end(), 0.0f);
+
+            fft.performFrequencyOnlyForwardTransform (fftData.data(), true);
+
+            for (size_t i = 0; i < (size_t) numPoints; ++i)
+            {
+                const auto& point = grid[i];
+                float power;
+
+                if (point.firstBin == point.lastBin && point.fraction > 0.0f)
+                {
+                    const auto magnitude = jmap (point.fraction, fftData[(size_t) point.firstBin], fftData[(size_t) point.firstBin + 1]);
+                    power = magnitude * magnitude;
+                }
+                else
+                {
+                    // The strongest bin, so a tone reads the same wherever it falls in the band
+                    auto peakMagnitude = 0.0f;
+
+                    for (auto bin = point.firstBin; bin <= point.lastBin; ++bin)
+                        peakMagnitude = jmax (peakMagnitude, fftData[(size_t) bin]);
+
+                    power = peakMagnitude * peakMagnitude;
+                }
+
+                const auto decibels = jmax (floorDecibels, 10.0f * std::log10 (power + 1.0e-30f) + decibelOffset);
+
+                auto& level = state.level[i];
+                const auto coefficient = decibels > level ? attackCoefficient : releaseCoefficient;
+                level = decibels + coefficient * (level - decibels);
+
+                auto& peak = state.peak[i];
+                auto& age = state.peakAge[i];
+
+                if (level >= peak)
+                {
+                    peak = level;
+                    age = 0;
+                }
+                else if (++age > peakHoldFrames)
+                {
+                    peak = jmax (level, peak - peakFallPerFrame);
+                }
+            }
+        }
+
+        void publish()
+        {
+            auto& spectrum = owner.spectrumExchange.getWriteBuffer();
+
+            for (size_t tap = 0; tap < (size_t) numTaps; ++tap)
+            {
+                spectrum.level[tap] = tapStates[tap].level;
+                spectrum.peak[tap] = tapStates[tap].peak;
+            }
+
+            owner.spectrumExchange.publish();
+        }
+
+        SpectrumAnalyzer& owner;
+
+        dsp::FFT fft;
+        const int fftSize, hopSize;
+        std::vector<float> window, fftData;
+        std::array<GridPoint, numPoints> grid;
+        std::array<TapState, numTaps> tapStates;
+
+        float decibelOffset = 0.0f;
+        float attackCoefficient = 0.0f, releaseCoefficient = 0.0f, peakFallPerFrame = 0.0f;
+        int peakHoldFrames = 0;
+    };
+
+    //==============================================================================
+    SpectrumAnalyzer::SpectrumAnalyzer() = default;
+
+    SpectrumAnalyzer::~SpectrumAnalyzer()
+    {
+        if (analysisThread != nullptr)
+            analysisThread->stopThread (2000);
+    }
+
+    void SpectrumAnalyzer::prepare (double sampleRate)
+    {
+        if (analysisThread != nullptr)
+            analysisThread->stopThread (2000);
+
+        const auto fifoSize = (1 << getFftOrder (sampleRate)) * fifoFramesOfHistory;
+
+        for (auto& tap : taps)
+        {
+            tap.samples.assign ((size_t) fifoSize, 0.0f);
+            tap.fifo.setTotalSize (fifoSize);
+        }
+
+        analysisThread = std::make_unique<AnalysisThread> (*this, sampleRate);
+        analysisThread->startThread (Thread::Priority::low);
+    }
+
+    void SpectrumAnalyzer::setEnabled (bool shouldBeEnabled)
+    {
+        enabled.store (shouldBeEnabled);
+
+        // A wake-up that comes before the thread has gone to sleep is kept until it does
+        if (shouldBeEnabled && analysisThread != nullptr)
+            analysisThread->notify();
+    }
+
+    template <typename SampleType>
+    void SpectrumAnalyzer::pushSamples (Tap tap, const dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        if (! isEnabled())
+            return;
+
+        const auto numChannels = block.getNumChannels();
+
+        if (numChannels == 0)
+            return;
+
+        auto& destination = taps[(size_t) tap];
+
+        // If the analysis thread has fallen behind the rest of the block is dropped; it only
+        // ever looks at the most recent window anyway
+        const auto scope = destination.fifo.write ((int) block.getNumSamples());
+        const auto gain = 1.0f / (float) numChannels;
+
+        const auto mixDown = [&] (int start, int num, size_t sourceOffset)
+        {
+            auto* out = destination.samples.data() + start;
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+            {
+                const auto* in = block.getChannelPointer (channel) + sourceOffset;
+
+                if (channel == 0)
+                    for (int i = 0; i < num; ++i)
+                        out[i] = (float) in[i] * gain;
+                else
+                    for (int i = 0; i < num; ++i)
+                        out[i] += (float) in[i] * gain;
+            }
+        };
+
+        if (scope.blockSize1 > 0)
+            mixDown (scope.startIndex1, scope.blockSize1, 0);
+
+        if (scope.blockSize2 > 0)
+            mixDown (scope.startIndex2, scope.blockSize2, (size_t) scope.blockSize1);
+    }
+
+    bool SpectrumAnalyzer::getLatestSpectrum (Spectrum& destination)
+    {
+        if (! spectrumExchange.pull())
+            return false;
+
+        destination = spectrumExchange.getReadBuffer();
+        return true;
+    }
+
+    template void SpectrumAnalyzer::pushSamples<float> (Tap, const dsp::AudioBlock<float>&) noexcept;
+    template void SpectrumAnalyzer::pushSamples<double> (Tap, const dsp::AudioBlock<double>&) noexcept;
+}
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.h
+    Pre / post EQ spectrum, analysed away from the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+namespace Dsp
+{
+    /**
+        Log-frequency spectra of the signal before and after the EQ.
+
+        The audio thread only mixes each tap down to mono and writes it into a lock-free
+        single producer FIFO, and does even that only while the analyzer is enabled. A
+        background thread reads the FIFOs, applies a Hann window with 75% overlap, runs the
+        FFT, folds the bins onto a fixed log-frequency grid and smooths them. It also keeps a
+        decaying peak hold. Finished frames go to the editor through a TripleBuffer, so
+        neither side ever waits.
+    */
+    class SpectrumAnalyzer
+    {
+    public:
+        enum Tap
+        {
+            preTap,
+            postTap,
+            numTaps
+        };
+
+        static constexpr int numPoints = 512;
+        static constexpr float minFrequency = 20.0f, maxFrequency = 20000.0f;
+        static constexpr float floorDecibels = -100.0f;
+
+        /** One frame for the editor: level in dBFS per grid point, log spaced from 20 Hz to 20 kHz. */
+        struct Spectrum
+        {
+            std::array<std::array<float, numPoints>, numTaps> level, peak;
+        };
+
+        SpectrumAnalyzer();
+        ~SpectrumAnalyzer();
+
+        /** Message thread: sizes the FIFOs and FFT buffers for the host rate. */
+        void prepare (double sampleRate);
+
+        /** Message thread: the analyzer costs nothing on either thread while disabled, its
+            thread sleeping until it is enabled again.
+        */
+        void setEnabled (bool shouldBeEnabled);
+        bool isEnabled() const noexcept                             { return enabled.load (std::memory_order_relaxed); }
+
+        /** Audio thread: queues the block for analysis, mixed down to mono. */
+        template <typename SampleType>
+        void pushSamples (Tap tap, const dsp::AudioBlock<SampleType>& block) noexcept;
+
+        /** Editor: takes the newest frame if there is one. @returns true if it changed. */
+        bool getLatestSpectrum (Spectrum& destination);
+
+    private:
+        class AnalysisThread;
+
+        struct TapFifo
+        {
+            AbstractFifo fifo { 1 };
+            std::vector<float> samples;
+        };
+
+        std::array<TapFifo, numTaps> taps;
+        std::atomic<bool> enabled { false };
+
+        // Analysis thread -> editor
+        TripleBuffer<Spectrum> spectrumExchange;
+
+        std::unique_ptr<AnalysisThread> analysisThread;
+
+        JUCE_DECLARE_NON_COPYABLE (SpectrumAnalyzer)
+    };
+}
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+    Wait-free single producer / single consumer handoff of a value.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp
+{
+    /**
+        Three slots and one atomic index: the producer fills its private slot and swaps it into
+        the middle with publish(), the consumer swaps the middle into its own slot with pull().
+
+        Neither side ever waits for the other and a value is only handed over whole, so the
+        consumer always sees the most recent complete value. Values published while the
+        consumer isn't looking are simply replaced by newer ones.
+
+        Only one thread may produce and only one may consume at a time; callers with several
+        producer threads have to serialise them on their side.
+    */
+    template <typename Type>
+    class TripleBuffer
+    {
+    public:
+        TripleBuffer() = default;
+
+        /** Producer: the slot to fill before calling publish(). Its previous contents are stale. */
+        Type& getWriteBuffer() noexcept                 { return slots[writeIndex]; }
+
+        /** Producer: hands the write buffer over to the consumer. */
+        void publish() noexcept
+        {
+            writeIndex = (size_t) (middle.exchange ((int) writeIndex | newDataFlag, std::memory_order_acq_rel) & indexMask);
+        }
+
+        /** Consumer: takes ownership of the most recently published value, if there is a new one.
+            @returns true if getReadBuffer() now refers to a value that wasn't seen before.
+        */
+        bool pull() noexcept
+        {
+            if ((middle.load (std::memory_order_relaxed) & newDataFlag) == 0)
+                return false;
+
+            readIndex = (size_t) (middle.exchange ((int) readIndex, std::memory_order_acq_rel) & indexMask);
+            return true;
+        }
+
+        /** Consumer: the value taken by the last successful pull(). */
+        const Type& getReadBuffer() const noexcept      { return slots[readIndex]; }
+
+    private:
+        static constexpr int indexMask = 3, newDataFlag = 4;
+
+        std::array<Type, 3> slots {};
+        size_t writeIndex = 0, readIndex = 1;
+        std::atomic<int> middle { 2 };
+
+        JUCE_DECLARE_NON_COPYABLE (TripleBuffer)
+    };
+}
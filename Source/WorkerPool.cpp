@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    WorkerPool.cpp
+    Real-time worker threads that help the audio thread through one block.
+
+  ==============================================================================
+*/
+
+#include "WorkerPool.h"
+#include "RealtimeAudit.h"
+#include "Semaphore.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+namespace Dsp
+{
+    namespace
+    {
+        inline void spinPause() noexcept
+        {
+           #if JUCE_INTEL
+            _mm_pause();
+           #elif JUCE_ARM && (JUCE_CLANG || JUCE_GCC)
+            __asm__ __volatile__ ("yield");
+           #endif
+        }
+
+        // Long enough to bridge the gap between sub-blocks, short enough not to burn a core
+        // between host callbacks
+        constexpr double spinSeconds = 0.0002;
+    }
+
+    //==============================================================================
+    class WorkerPool::Worker  : public Thread
+    {
+    public:
+        Worker (WorkerPool& ownerPool, int index)
+            : Thread ("EQ worker " + String (index)), pool (ownerPool)
+        {
+        }
+
+        // One post per park; a post that arrives after the worker has already seen the new run
+        // only costs it one extra turn round the loop later
+        void wake() noexcept
+        {
+            if (parked.exchange (false, std::memory_order_seq_cst))
+                wakeUp.post();
+        }
+
+        void stop()
+        {
+            signalThreadShouldExit();
+            wakeUp.post();
+            stopThread (1000);
+        }
+
+        void run() override
+        {
+            const auto spinTicks = Time::secondsToHighResolutionTicks (spinSeconds);
+
+            auto seen = getGeneration (pool.claim.load (std::memory_order_acquire));
+            auto idleSince = Time::getHighResolutionTicks();
+
+            while (! threadShouldExit())
+            {
+                const auto latest = getGeneration (pool.claim.load (std::memory_order_acquire));
+
+                if (latest != seen)
+                {
+                    seen = latest;
+
+                    const RealtimeAudit::ScopedAudioThread audioThread;
+
+                    while (pool.runNextJob (seen)) {}
+
+                    idleSince = Time::getHighResolutionTicks();
+                    continue;
+                }
+
+                if (Time::getHighResolutionTicks() - idleSince < spinTicks)
+                {
+                    spinPause();
+                    continue;
+                }
+
+                // Announce the park before the last look, so a run() that starts in between
+                // either gets seen here or sees us parked and signals
+                parked.store (true, std::memory_order_seq_cst);
+
+                if (getGeneration (pool.claim.load (std::memory_order_seq_cst)) == seen && ! threadShouldExit())
+                    wakeUp.wait();
+
+                parked.store (false, std::memory_order_relaxed);
+                idleSince = Time::getHighResolutionTicks();
+            }
+        }
+
+    private:
+        WorkerPool& pool;
+        Semaphore wakeUp;
+        std::atomic<bool> parked { false };
+    };
+
+    //==============================================================================
+    WorkerPool::WorkerPool (int numWorkers, double blockPeriodMs)
+    {
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            auto* worker = workers.add (new Worker (*this, i + 1));
+
+            if (! worker->startRealtimeThread (Thread::RealtimeOptions{}.withPeriodMs (blockPeriodMs)))
+                worker->startThread (Thread::Priority::highest);
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        for (auto* worker : workers)
+            worker->stop();
+    }
+
+    void WorkerPool::run (int numJobs, JobFunction job, void* context) noexcept
+    {
+        if (numJobs <= 0)
+            return;
+
+        currentJob.store (job, std::memory_order_relaxed);
+        currentContext.store (context, std::memory_order_relaxed);
+        numJobsInRun.store (numJobs, std::memory_order_relaxed);
+        numCompleted.store (0, std::memory_order_relaxed);
+
+        ++generation;
+        claim.store ((uint64) generation << 32, std::memory_order_seq_cst);
+
+        for (auto* worker : workers)
+            worker->wake();
+
+        while (runNextJob (generation)) {}
+
+        while (numCompleted.load (std::memory_order_acquire) < numJobs)
+            spinPause();
+    }
+
+    bool WorkerPool::runNextJob (uint32 runGeneration) noexcept
+    {
+        auto current = claim.load (std::memory_order_acquire);
+
+        for (;;)
+        {
+            if (getGeneration (current) != runGeneration)
+                return false;
+
+            const auto index = (int) (current & 0xffffffffu);
+
+            // These can only belong to a later run if every index of this one has been taken
+            // already, in which case the exchange below fails
+            const auto job = currentJob.load (std::memory_order_relaxed);
+            const auto context = currentContext.load (std::memory_order_relaxed);
+
+            if (index >= numJobsInRun.load (std::memory_order_relaxed))
+                return false;
+
+            if (claim.compare_exchange_weak (current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                job (context, index);
+                numCompleted.fetch_add (1, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+}
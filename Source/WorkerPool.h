@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    WorkerPool.h
+    Real-time worker threads that help the audio thread through one block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp
+{
+    /**
+        A small set of real-time threads that share the jobs of one run() with its caller.
+
+        Jobs are handed out through a single atomic claim word holding the run's generation and
+        the next unclaimed index. The calling thread and every worker keep claiming until none
+        are left, so a thread that finishes early simply takes the next group instead of
+        waiting, and run() returns once the last claimed job has finished.
+
+        Idle workers spin for a short while, so back-to-back blocks find them awake, and then
+        park on a semaphore. Neither run() nor the workers allocate or lock. The only system
+        call left on the calling thread is posting the semaphore of a worker that has parked,
+        which takes no mutex but does enter the kernel, so a pool that parks between every
+        pair of blocks pays for one wake-up per worker per block.
+    */
+    class WorkerPool
+    {
+    public:
+        using JobFunction = void (*) (void* context, int jobIndex);
+
+        /** Starts the workers with real-time priority; the period is a hint for the OS scheduler. */
+        WorkerPool (int numWorkers, double blockPeriodMs);
+        ~WorkerPool();
+
+        int getNumWorkers() const noexcept                  { return workers.size(); }
+
+        /** Calls job (context, i) for every i in [0, numJobs) and returns once all have finished.
+            Only one thread may call this at a time.
+        */
+        void run (int numJobs, JobFunction job, void* context) noexcept;
+
+    private:
+        class Worker;
+
+        bool runNextJob (uint32 runGeneration) noexcept;
+
+        static uint32 getGeneration (uint64 claimWord) noexcept  { return (uint32) (claimWord >> 32); }
+
+        OwnedArray<Worker> workers;
+
+        // generation << 32 | next job index
+        std::atomic<uint64> claim { 0 };
+
+        std::atomic<JobFunction> currentJob { nullptr };
+        std::atomic<void*> currentContext { nullptr };
+        std::atomic<int> numJobsInRun { 0 }, numCompleted { 0 };
+        uint32 generation = 0;
+
+        JUCE_DECLARE_NON_COPYABLE (WorkerPool)
+    };
+}
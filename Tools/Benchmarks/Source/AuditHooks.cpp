@@ -0,0 +1,222 @@
+/*
+  ==============================================================================
+
+    AuditHooks.cpp
+    Audit builds only: routes allocations, locks and blocking calls to the audit.
+
+  ==============================================================================
+*/
+
+#include "../../../Source/RealtimeAudit.h"
+
+#if EZEQ_REALTIME_AUDIT
+
+/*  Linux: these definitions take the place of the C library's for the whole process, and
+    pass the calls on to the originals behind them.
+
+    macOS: dyld swaps the functions listed in the __interpose section for the hooks in every
+    other image, the system libraries included.
+
+    Windows: the debug CRT reports every heap operation to an allocation hook, and replacing
+    operator new covers release builds. Locks and blocking calls are not hooked there.
+*/
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <unistd.h>
+ #include <poll.h>
+ #include <time.h>
+ #include <dlfcn.h>
+ #include <errno.h>
+#elif JUCE_WINDOWS
+ #include <crtdbg.h>
+#endif
+
+namespace
+{
+    inline void report (Dsp::RealtimeAudit::Violation type) noexcept
+    {
+        Dsp::RealtimeAudit::reportViolation (type);
+    }
+}
+
+#if JUCE_LINUX || JUCE_MAC
+
+// violation, return type, name, parameters, arguments
+#define EZEQ_AUDITED_FUNCTIONS(X) \
+    X (mutexLock,    int,     pthread_mutex_lock,     (pthread_mutex_t* m),                                   (m)) \
+    X (mutexLock,    int,     pthread_rwlock_rdlock,  (pthread_rwlock_t* l),                                  (l)) \
+    X (mutexLock,    int,     pthread_rwlock_wrlock,  (pthread_rwlock_t* l),                                  (l)) \
+    X (blockingCall, int,     pthread_cond_wait,      (pthread_cond_t* c, pthread_mutex_t* m),                (c, m)) \
+    X (blockingCall, int,     pthread_cond_timedwait, (pthread_cond_t* c, pthread_mutex_t* m, const timespec* t), (c, m, t)) \
+    X (blockingCall, int,     pthread_join,           (pthread_t t, void** r),                                (t, r)) \
+    X (blockingCall, int,     sem_wait,               (sem_t* s),                                             (s)) \
+    X (blockingCall, int,     nanosleep,              (const timespec* t, timespec* r),                       (t, r)) \
+    X (blockingCall, int,     usleep,                 (useconds_t t),                                         (t)) \
+    X (blockingCall, unsigned int, sleep,             (unsigned int t),                                       (t)) \
+    X (blockingCall, ssize_t, read,                   (int f, void* b, size_t n),                             (f, b, n)) \
+    X (blockingCall, ssize_t, write,                  (int f, const void* b, size_t n),                       (f, b, n)) \
+    X (blockingCall, int,     poll,                   (pollfd* f, nfds_t n, int t),                           (f, n, t)) \
+    X (blockingCall, int,     fsync,                  (int f),                                                (f))
+
+#endif
+
+#if JUCE_LINUX
+
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void __libc_free (void*);
+
+    // The allocator can't be looked up with dlsym, which allocates itself
+    void* malloc (size_t size)                              { report (Dsp::RealtimeAudit::allocation); return __libc_malloc (size); }
+    void* calloc (size_t count, size_t size)                { report (Dsp::RealtimeAudit::allocation); return __libc_calloc (count, size); }
+    void* realloc (void* p, size_t size)                    { report (Dsp::RealtimeAudit::allocation); return __libc_realloc (p, size); }
+    void* memalign (size_t alignment, size_t size)          { report (Dsp::RealtimeAudit::allocation); return __libc_memalign (alignment, size); }
+    void* aligned_alloc (size_t alignment, size_t size)     { report (Dsp::RealtimeAudit::allocation); return __libc_memalign (alignment, size); }
+
+    int posix_memalign (void** result, size_t alignment, size_t size)
+    {
+        report (Dsp::RealtimeAudit::allocation);
+        *result = __libc_memalign (alignment, size);
+        return *result != nullptr ? 0 : ENOMEM;
+    }
+
+    void free (void* p)
+    {
+        if (p != nullptr)
+            report (Dsp::RealtimeAudit::deallocation);
+
+        __libc_free (p);
+    }
+}
+
+// The originals are looked up on first use, or at start up at the latest, so that the
+// lookup itself never happens on the audio thread
+#define EZEQ_DEFINE_HOOK(violation, returnType, name, parameters, arguments) \
+    static returnType (*original_##name) parameters = nullptr; \
+    \
+    static void resolve_##name() noexcept \
+    { \
+        if (original_##name == nullptr) \
+            original_##name = reinterpret_cast<returnType (*) parameters> (dlsym (RTLD_NEXT, #name)); \
+    } \
+    \
+    extern "C" returnType name parameters \
+    { \
+        resolve_##name(); \
+        report (Dsp::RealtimeAudit::violation); \
+        return original_##name arguments; \
+    }
+
+#define EZEQ_RESOLVE_HOOK(violation, returnType, name, parameters, arguments) resolve_##name();
+
+EZEQ_AUDITED_FUNCTIONS (EZEQ_DEFINE_HOOK)
+
+static const bool hooksResolved = []
+{
+    EZEQ_AUDITED_FUNCTIONS (EZEQ_RESOLVE_HOOK)
+    return true;
+}();
+
+#elif JUCE_MAC
+
+#define EZEQ_INTERPOSE(replacement, replacee) \
+    __attribute__ ((used)) static const struct { const void* replacementFunction; const void* replaceeFunction; } \
+        interpose_##replacee __attribute__ ((section ("__DATA,__interpose"))) = { (const void*) &replacement, (const void*) &replacee };
+
+// Calls from this image are not interposed, so the hooks reach the originals by name
+#define EZEQ_DEFINE_HOOK(violation, returnType, name, parameters, arguments) \
+    static returnType audited_##name parameters \
+    { \
+        report (Dsp::RealtimeAudit::violation); \
+        return name arguments; \
+    } \
+    \
+    EZEQ_INTERPOSE (audited_##name, name)
+
+static void* audited_malloc (size_t size)                           { report (Dsp::RealtimeAudit::allocation); return malloc (size); }
+static void* audited_calloc (size_t count, size_t size)             { report (Dsp::RealtimeAudit::allocation); return calloc (count, size); }
+static void* audited_realloc (void* p, size_t size)                 { report (Dsp::RealtimeAudit::allocation); return realloc (p, size); }
+static int audited_posix_memalign (void** result, size_t alignment, size_t size)
+{
+    report (Dsp::RealtimeAudit::allocation);
+    return posix_memalign (result, alignment, size);
+}
+
+static void audited_free (void* p)
+{
+    if (p != nullptr)
+        report (Dsp::RealtimeAudit::deallocation);
+
+    free (p);
+}
+
+EZEQ_INTERPOSE (audited_malloc, malloc)
+EZEQ_INTERPOSE (audited_calloc, calloc)
+EZEQ_INTERPOSE (audited_realloc, realloc)
+EZEQ_INTERPOSE (audited_posix_memalign, posix_memalign)
+EZEQ_INTERPOSE (audited_free, free)
+
+EZEQ_AUDITED_FUNCTIONS (EZEQ_DEFINE_HOOK)
+
+#elif JUCE_WINDOWS
+
+#if defined (_DEBUG)
+
+static int auditAllocationHook (int operation, void*, size_t, int, long, const unsigned char*, int)
+{
+    report (operation == _HOOK_FREE ? Dsp::RealtimeAudit::deallocation : Dsp::RealtimeAudit::allocation);
+    return 1;
+}
+
+static const auto previousAllocationHook = _CrtSetAllocHook (auditAllocationHook);
+
+#else
+
+// Without the debug CRT only what goes through operator new is seen; the other forms of
+// new and delete forward to these
+void* operator new (std::size_t size)
+{
+    report (Dsp::RealtimeAudit::allocation);
+
+    if (auto* p = std::malloc (size != 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    report (Dsp::RealtimeAudit::allocation);
+
+    if (auto* p = _aligned_malloc (size != 0 ? size : 1, (size_t) alignment))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* p) noexcept
+{
+    if (p != nullptr)
+        report (Dsp::RealtimeAudit::deallocation);
+
+    std::free (p);
+}
+
+void operator delete (void* p, std::align_val_t) noexcept
+{
+    if (p != nullptr)
+        report (Dsp::RealtimeAudit::deallocation);
+
+    _aligned_free (p);
+}
+
+#endif
+#endif
+
+#endif
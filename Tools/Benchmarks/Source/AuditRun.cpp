@@ -0,0 +1,364 @@
+/*
+  ==============================================================================
+
+    AuditRun.cpp
+    Automation, preset loads and editor use against the real-time audit.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/PluginEditor.h"
+#include "../../../Source/RealtimeAudit.h"
+
+namespace Benchmarks
+{
+   #if EZEQ_REALTIME_AUDIT
+    namespace
+    {
+        namespace Audit = Dsp::RealtimeAudit;
+
+        constexpr double sampleRate = 48000.0;
+
+        /** Stands in for the host's audio callback. Each block the scenario may change
+            parameters first, from this thread and outside processBlock as a plugin wrapper
+            does, and then the block is processed. Blocks come at the real-time rate so the
+            message thread gets to run alongside.
+        */
+        template <typename SampleType>
+        class AudioThread  : public juce::Thread
+        {
+        public:
+            using BeforeBlock = std::function<void (int blockIndex)>;
+
+            AudioThread (SimpleEQAudioProcessor& processorToUse, int numChannels, int blockSizeToUse, BeforeBlock beforeBlockToUse)
+                : juce::Thread ("EQ audit audio"),
+                  processor (processorToUse),
+                  blockSize (blockSizeToUse),
+                  beforeBlock (std::move (beforeBlockToUse)),
+                  buffer (numChannels, blockSize),
+                  noise (numChannels, (int) sampleRate)
+            {
+                juce::Random random (0xa0d17);
+
+                for (int channel = 0; channel < noise.getNumChannels(); ++channel)
+                    for (int i = 0; i < noise.getNumSamples(); ++i)
+                        noise.setSample (channel, i, (SampleType) ((random.nextFloat() * 2.0f - 1.0f) * 0.25f));
+            }
+
+            void run() override
+            {
+                const auto periodMs = juce::jmax (1, juce::roundToInt (1000.0 * blockSize / sampleRate));
+                auto position = 0;
+
+                for (int block = 0; ! threadShouldExit(); ++block)
+                {
+                    if (beforeBlock != nullptr)
+                        beforeBlock (block);
+
+                    if (position + blockSize > noise.getNumSamples())
+                        position = 0;
+
+                    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                        buffer.copyFrom (channel, 0, noise, channel, position, blockSize);
+
+                    position += blockSize;
+
+                    processor.processBlock (buffer, midi);
+                    numBlocks.store (block + 1);
+
+                    wait (periodMs);
+                }
+            }
+
+            int getNumBlocks() const noexcept       { return numBlocks.load(); }
+
+        private:
+            SimpleEQAudioProcessor& processor;
+            const int blockSize;
+            BeforeBlock beforeBlock;
+
+            juce::AudioBuffer<SampleType> buffer, noise;
+            juce::MidiBuffer midi;
+            std::atomic<int> numBlocks { 0 };
+        };
+
+        /** Keeps the message thread running timers and async updates until the time is up. */
+        template <typename Callback>
+        void runMessageLoop (int milliseconds, int tickMs, Callback&& onTick)
+        {
+            const auto end = juce::Time::getMillisecondCounter() + (juce::uint32) milliseconds;
+
+            for (int tick = 0; juce::Time::getMillisecondCounter() < end; ++tick)
+            {
+                onTick (tick);
+                juce::MessageManager::getInstance()->runDispatchLoopUntil (tickMs);
+            }
+        }
+
+        /** Every band parameter moves on every block, jumps and sweeps alike, and unless told
+            otherwise the global modes switch every few dozen blocks, each a different way round.
+            Choices and switches land on their steps, so any normalised value will do for them.
+        */
+        void automate (SimpleEQAudioProcessor& processor, juce::Random& random, int blockIndex, bool switchModes = true)
+        {
+            auto& apvts = processor.apvts;
+
+            for (int band = 1; band <= 6; ++band)
+            {
+                const auto suffix = juce::String (band);
+                const auto sweep = 0.5f + 0.4f * std::sin ((float) blockIndex * 0.05f + (float) band);
+
+                apvts.getParameter ("Freq" + suffix)->setValueNotifyingHost (sweep);
+                apvts.getParameter ("Gain" + suffix)->setValueNotifyingHost (random.nextFloat());
+                apvts.getParameter ("Q" + suffix)->setValueNotifyingHost (1.0f - sweep);
+
+                if (blockIndex % 7 == band)
+                {
+                    apvts.getParameter ("Type" + suffix)->setValueNotifyingHost (random.nextFloat());
+                    apvts.getParameter ("Bypass" + suffix)->setValueNotifyingHost (random.nextBool() ? 1.0f : 0.0f);
+                }
+            }
+
+            static const char* const modes[] { "Design", "Precision", "SmoothingBlock", "Oversampling", "PhaseMode", "LinearPhaseQuality" };
+
+            if (switchModes && blockIndex % 40 == 39)
+                apvts.getParameter (modes[(blockIndex / 40) % (int) std::size (modes)])->setValueNotifyingHost (random.nextFloat());
+        }
+
+        /** A preset as the preset manager would hand it over: the saved tree with new values. */
+        juce::ValueTree createRandomPreset (SimpleEQAudioProcessor& processor, juce::Random& random)
+        {
+            auto preset = processor.apvts.copyState();
+
+            for (auto child : preset)
+            {
+                const auto parameterID = child["id"].toString();
+
+                if (auto* parameter = processor.apvts.getParameter (parameterID))
+                    if (parameterID.startsWith ("Freq") || parameterID.startsWith ("Gain") || parameterID.startsWith ("Q")
+                         || parameterID.startsWith ("Type") || parameterID.startsWith ("Bypass"))
+                        child.setProperty ("value", parameter->convertFrom0to1 (random.nextFloat()), nullptr);
+            }
+
+            return preset;
+        }
+
+        /** The editor's controls, leaving out the preset panel, which would write to the preset folder. */
+        void findControls (juce::Component& parent, juce::Array<juce::Slider*>& sliders,
+                           juce::Array<juce::ComboBox*>& combos, juce::Array<juce::Button*>& buttons)
+        {
+            for (auto* child : parent.getChildren())
+            {
+                if (dynamic_cast<Gui::PresetPanel*> (child) != nullptr)
+                    continue;
+
+                if (auto* slider = dynamic_cast<juce::Slider*> (child))
+                    sliders.add (slider);
+                else if (auto* combo = dynamic_cast<juce::ComboBox*> (child))
+                    combos.add (combo);
+                else if (auto* button = dynamic_cast<juce::Button*> (child))
+                    buttons.add (button);
+                else
+                    findControls (*child, sliders, combos, buttons);
+            }
+        }
+
+        /** Flips a switch parameter, e.g. to have the message thread build and drop what it needs. */
+        void toggle (SimpleEQAudioProcessor& processor, const juce::String& parameterID)
+        {
+            auto* parameter = processor.apvts.getParameter (parameterID);
+            parameter->setValueNotifyingHost (parameter->getValue() >= 0.5f ? 0.0f : 1.0f);
+        }
+
+        struct Scenario
+        {
+            juce::String name;
+            bool doublePrecision = false;
+            std::function<void (SimpleEQAudioProcessor&, int blockIndex)> onAudioThread;
+            std::function<void (SimpleEQAudioProcessor&, int milliseconds)> onMessageThread;
+            int numChannels = 2;
+
+            // Set before prepareToPlay, so the audio thread starts out in these modes
+            SimpleEQAudioProcessor::ParameterValues parameters;
+        };
+
+        template <typename SampleType>
+        int runScenario (const Scenario& scenario, int milliseconds, int blockSize)
+        {
+            SimpleEQAudioProcessor processor;
+            processor.applyParameterValues (scenario.parameters);
+
+            const auto channelSet = juce::AudioChannelSet::canonicalChannelSet (scenario.numChannels);
+            juce::AudioProcessor::BusesLayout layout;
+            layout.inputBuses.add (channelSet);
+            layout.outputBuses.add (channelSet);
+
+            if (! processor.setBusesLayout (layout))
+            {
+                std::cout << scenario.name.paddedRight (' ', 24) << "error: " << scenario.numChannels << " channels is not a supported layout" << std::endl;
+                return 1;
+            }
+
+            processor.setProcessingPrecision (scenario.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                       : juce::AudioProcessor::singlePrecision);
+            processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+            processor.prepareToPlay (sampleRate, blockSize);
+
+            typename AudioThread<SampleType>::BeforeBlock beforeBlock;
+
+            if (scenario.onAudioThread != nullptr)
+                beforeBlock = [&processor, &scenario] (int blockIndex) { scenario.onAudioThread (processor, blockIndex); };
+
+            Audit::reset();
+
+            AudioThread<SampleType> audioThread (processor, scenario.numChannels, blockSize, std::move (beforeBlock));
+            audioThread.startThread (juce::Thread::Priority::highest);
+
+            if (scenario.onMessageThread != nullptr)
+                scenario.onMessageThread (processor, milliseconds);
+            else
+                runMessageLoop (milliseconds, 10, [] (int) {});
+
+            audioThread.stopThread (2000);
+            processor.releaseResources();
+
+            const auto total = Audit::getTotalViolations();
+
+            std::cout << scenario.name.paddedRight (' ', 24) << juce::String (audioThread.getNumBlocks()).paddedLeft (' ', 7) << " blocks";
+
+            for (int type = 0; type < Audit::numViolations; ++type)
+                std::cout << "  " << Audit::getViolationName ((Audit::Violation) type) << " "
+                          << Audit::getNumViolations ((Audit::Violation) type);
+
+            std::cout << std::endl;
+
+            if (total > 0)
+                std::cout << std::endl << Audit::getReport() << std::endl;
+
+            return total;
+        }
+    }
+   #endif
+
+    int runAudit (const juce::StringArray& args)
+    {
+       #if EZEQ_REALTIME_AUDIT
+        const auto milliseconds = 1000 * juce::jmax (1, getIntOption (args, "--seconds", 5));
+        const auto blockSize = juce::jmax (16, getIntOption (args, "--block", 512));
+        const auto filter = getStringOption (args, "--filter", {});
+
+        juce::Random random (0xa0d17);
+        std::vector<Scenario> scenarios;
+
+        scenarios.push_back ({ "automation/float", false, [&random] (SimpleEQAudioProcessor& p, int block) { automate (p, random, block); }, nullptr });
+        scenarios.push_back ({ "automation/double", true, [&random] (SimpleEQAudioProcessor& p, int block) { automate (p, random, block); }, nullptr });
+
+        // The widest layout, so the channel groups go out to the worker pool, which the message
+        // thread drops and builds again as Multicore goes off and on
+        scenarios.push_back ({ "multicore/7.1.4", false, [&random] (SimpleEQAudioProcessor& p, int block)
+        {
+            automate (p, random, block, false);
+
+            if (block % 100 == 99)
+                toggle (p, "Multicore");
+        }, nullptr, 12, { { "Multicore", 1.0f } } });
+
+        // Linear phase from the very first block: every band change wakes the kernel thread,
+        // and quality changes have the message thread build new convolvers
+        scenarios.push_back ({ "linearphase", false, [&random] (SimpleEQAudioProcessor& p, int block)
+        {
+            automate (p, random, block, false);
+
+            if (block % 100 == 99)
+                p.apvts.getParameter ("LinearPhaseQuality")->setValueNotifyingHost (random.nextFloat());
+        }, nullptr, 2, { { "PhaseMode", 1.0f } } });
+
+        // Presets arrive on the message thread, through the preset manager's path and as a host's state restore
+        scenarios.push_back ({ "presets", false, nullptr, [&random] (SimpleEQAudioProcessor& p, int ms)
+        {
+            SimpleEQAudioProcessor source;
+
+            runMessageLoop (ms, 20, [&] (int tick)
+            {
+                if (tick % 2 == 0)
+                {
+                    p.applyParameterState (createRandomPreset (p, random));
+                }
+                else
+                {
+                    source.applyParameterState (createRandomPreset (source, random));
+
+                    juce::MemoryBlock state;
+                    source.getStateInformation (state);
+                    p.setStateInformation (state.getData(), (int) state.getSize());
+                }
+            });
+        } });
+
+        // Somebody working the editor: knobs, band types, buttons, resizing and repaints
+        scenarios.push_back ({ "editor", false, nullptr, [&random] (SimpleEQAudioProcessor& p, int ms)
+        {
+            std::unique_ptr<juce::AudioProcessorEditor> editor (p.createEditorIfNeeded());
+
+            juce::Array<juce::Slider*> sliders;
+            juce::Array<juce::ComboBox*> combos;
+            juce::Array<juce::Button*> buttons;
+            findControls (*editor, sliders, combos, buttons);
+
+            const auto width = editor->getWidth(), height = editor->getHeight();
+
+            runMessageLoop (ms, 15, [&] (int tick)
+            {
+                if (! sliders.isEmpty())
+                {
+                    auto* slider = sliders[random.nextInt (sliders.size())];
+                    slider->setValue (slider->proportionOfLengthToValue (random.nextDouble()), juce::sendNotificationSync);
+                }
+
+                if (tick % 10 == 0 && ! combos.isEmpty())
+                {
+                    auto* combo = combos[random.nextInt (combos.size())];
+                    combo->setSelectedItemIndex (random.nextInt (juce::jmax (1, combo->getNumItems())), juce::sendNotificationSync);
+                }
+
+                if (tick % 15 == 0 && ! buttons.isEmpty())
+                    buttons[random.nextInt (buttons.size())]->triggerClick();
+
+                if (tick % 50 == 0)
+                {
+                    const auto scale = 0.75f + random.nextFloat() * 0.5f;
+                    editor->setSize (juce::roundToInt ((float) width * scale), juce::roundToInt ((float) height * scale));
+                }
+
+                if (tick % 5 == 0)
+                    editor->createComponentSnapshot (editor->getLocalBounds());
+            });
+
+            editor.reset();
+        } });
+
+        auto total = 0;
+
+        for (const auto& scenario : scenarios)
+        {
+            if (filter.isNotEmpty() && ! scenario.name.startsWith (filter))
+                continue;
+
+            total += scenario.doublePrecision ? runScenario<double> (scenario, milliseconds, blockSize)
+                                              : runScenario<float> (scenario, milliseconds, blockSize);
+        }
+
+        std::cout << std::endl << (total == 0 ? "passed: nothing on the audio thread allocated, locked or blocked"
+                                             : "failed: " + juce::String (total) + " calls on the audio thread that are not real-time safe")
+                  << std::endl;
+
+        return total == 0 ? 0 : 1;
+       #else
+        juce::ignoreUnused (args);
+        std::cout << "error: built without EZEQ_REALTIME_AUDIT; use the Audit configuration" << std::endl;
+        return 1;
+       #endif
+    }
+}
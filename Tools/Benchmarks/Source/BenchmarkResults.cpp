@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    BenchmarkResults.cpp
+    Named measurements, written as JSON and compared between builds.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "BenchmarkResults.h"
+
+namespace Benchmarks
+{
+    void Results::add (const juce::String& name, double value, const juce::String& unit, bool lowerIsBetter)
+    {
+        entries.push_back ({ name, value, unit, lowerIsBetter });
+    }
+
+    const Results::Entry* Results::find (const juce::String& name) const
+    {
+        for (const auto& entry : entries)
+            if (entry.name == name)
+                return &entry;
+
+        return nullptr;
+    }
+
+    juce::String Results::toJson() const
+    {
+        juce::Array<juce::var> list;
+
+        for (const auto& entry : entries)
+        {
+            auto* object = new juce::DynamicObject();
+            object->setProperty ("name", entry.name);
+            object->setProperty ("value", entry.value);
+            object->setProperty ("unit", entry.unit);
+            object->setProperty ("lowerIsBetter", entry.lowerIsBetter);
+            list.add (juce::var (object));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty ("date", juce::Time::getCurrentTime().toISO8601 (true));
+        root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty ("cores", juce::SystemStats::getNumPhysicalCpus());
+        root->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+        root->setProperty ("results", list);
+
+        return juce::JSON::toString (juce::var (root));
+    }
+
+    juce::Result Results::fromJson (const juce::String& json, Results& destination)
+    {
+        const auto root = juce::JSON::parse (json);
+        const auto* list = root["results"].getArray();
+
+        if (list == nullptr)
+            return juce::Result::fail ("no results in the file");
+
+        // Files written before the flag existed only had lower is better measurements
+        for (const auto& item : *list)
+            destination.add (item["name"].toString(), (double) item["value"], item["unit"].toString(),
+                             (bool) item.getProperty ("lowerIsBetter", true));
+
+        return juce::Result::ok();
+    }
+
+    //==============================================================================
+    int runCompare (const juce::StringArray& args)
+    {
+        if (args.size() < 2)
+        {
+            std::cout << "usage: EZEQBenchmarks compare <baseline.json> <current.json> [--threshold 5]" << std::endl;
+            return 1;
+        }
+
+        const auto threshold = getIntOption (args, "--threshold", 5);
+        std::array<Results, 2> runs;
+
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            const auto file = juce::File::getCurrentWorkingDirectory().getChildFile (args[(int) i]);
+            const auto result = Results::fromJson (file.loadFileAsString(), runs[i]);
+
+            if (result.failed())
+            {
+                std::cout << "error: " << file.getFullPathName() << ": " << result.getErrorMessage() << std::endl;
+                return 1;
+            }
+        }
+
+        const auto& [baseline, current] = runs;
+        auto numRegressions = 0, numImprovements = 0;
+
+        for (const auto& entry : current.getEntries())
+        {
+            const auto* before = baseline.find (entry.name);
+
+            if (before == nullptr)
+            {
+                std::cout << "  new         " << entry.name << std::endl;
+                continue;
+            }
+
+            // No percentage of nothing; shown, but it can't pass or fail
+            if (before->value == 0.0)
+            {
+                std::cout << "  " << juce::String ("n/a").paddedLeft (' ', 8) << "   "
+                          << entry.name.paddedRight (' ', 40) << " "
+                          << juce::String (before->value, 2) << " -> " << juce::String (entry.value, 2) << " " << entry.unit << std::endl;
+                continue;
+            }
+
+            // Relative to the size of the baseline, so a value below zero changes the right way
+            const auto change = 100.0 * (entry.value - before->value) / std::abs (before->value);
+            const auto worse = entry.lowerIsBetter ? change > threshold : change < -threshold;
+            const auto better = entry.lowerIsBetter ? change < -threshold : change > threshold;
+            const auto* verdict = "  ";
+
+            if (worse)
+            {
+                verdict = "! ";
+                ++numRegressions;
+            }
+            else if (better)
+            {
+                verdict = "+ ";
+                ++numImprovements;
+            }
+
+            const auto changeText = (change >= 0.0 ? "+" : "") + juce::String (change, 1) + "%";
+
+            std::cout << verdict << changeText.paddedLeft (' ', 8) << "   "
+                      << entry.name.paddedRight (' ', 40) << " "
+                      << juce::String (before->value, 2) << " -> " << juce::String (entry.value, 2) << " " << entry.unit << std::endl;
+        }
+
+        for (const auto& entry : baseline.getEntries())
+            if (current.find (entry.name) == nullptr)
+                std::cout << "  missing     " << entry.name << std::endl;
+
+        std::cout << std::endl
+                  << numRegressions << " worse and " << numImprovements << " better by more than "
+                  << threshold << "%" << std::endl;
+
+        return numRegressions == 0 ? 0 : 1;
+    }
+}
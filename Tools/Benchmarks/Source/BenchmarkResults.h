@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    BenchmarkResults.h
+    Named measurements, written as JSON and compared between builds.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Benchmarks
+{
+    /**
+        A flat list of measurements, e.g. "dsp/block/64" in ns/sample. Lower is better unless
+        a measurement says otherwise, which it has to for rates and the like.
+
+        Written as JSON along with the machine it was taken on, so two runs of different
+        builds on the same machine can be compared with runCompare().
+    */
+    class Results
+    {
+    public:
+        struct Entry
+        {
+            juce::String name;
+            double value = 0.0;
+            juce::String unit;
+            bool lowerIsBetter = true;
+        };
+
+        void add (const juce::String& name, double value, const juce::String& unit, bool lowerIsBetter = true);
+
+        const std::vector<Entry>& getEntries() const noexcept       { return entries; }
+        const Entry* find (const juce::String& name) const;
+
+        juce::String toJson() const;
+        static juce::Result fromJson (const juce::String& json, Results& destination);
+
+    private:
+        std::vector<Entry> entries;
+    };
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    Benchmarks.h
+    Entry points of the benchmark commands.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Benchmarks
+{
+    /** Restores a saved state into many instances at once, the way a host loads a session. */
+    int runStateBenchmark (const juce::StringArray& args);
+
+    /** Times processBlock, parameter automation and the response curve; optionally writes JSON. */
+    int runMicroBenchmarks (const juce::StringArray& args);
+
+    /** Runs hundreds of instances round-robin like a host; callback times, memory and load. */
+    int runSessionBenchmark (const juce::StringArray& args);
+
+    /** Audit builds: automation, preset loads and editor use; fails if the audio thread allocated, locked or blocked. */
+    int runAudit (const juce::StringArray& args);
+
+    /** Races transactions, host automation and the editor's reads against processBlock; fails on a torn setup. */
+    int runStressTest (const juce::StringArray& args);
+
+    /** Compares two JSON results and fails if anything got worse than the threshold allows. */
+    int runCompare (const juce::StringArray& args);
+
+    /** Reads "--name value" from the arguments, or returns the fallback. */
+    inline int getIntOption (const juce::StringArray& args, const juce::String& name, int fallback)
+    {
+        const auto index = args.indexOf (name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1].getIntValue() : fallback;
+    }
+
+    /** The same for a text option. */
+    inline juce::String getStringOption (const juce::StringArray& args, const juce::String& name, const juce::String& fallback)
+    {
+        const auto index = args.indexOf (name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1] : fallback;
+    }
+}
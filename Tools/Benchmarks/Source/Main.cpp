@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Benchmarks for the EZEQ processor, one command per benchmark.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "Benchmarks.h"
+
+int main (int argc, char* argv[])
+{
+    // The processor starts timers and owns message thread objects, so it needs a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add (argv[i]);
+
+    const auto command = args[0];
+    args.remove (0);
+
+    if (command == "state")
+        return Benchmarks::runStateBenchmark (args);
+
+    if (command == "micro")
+        return Benchmarks::runMicroBenchmarks (args);
+
+    if (command == "session")
+        return Benchmarks::runSessionBenchmark (args);
+
+    if (command == "audit")
+        return Benchmarks::runAudit (args);
+
+    if (command == "stress")
+        return Benchmarks::runStressTest (args);
+
+    if (command == "compare")
+        return Benchmarks::runCompare (args);
+
+    std::cout << "usage: EZEQBenchmarks <command> [options]" << std::endl
+              << std::endl
+              << "  state [--instances 500] [--repeats 5]" << std::endl
+              << "      restores a session state into every instance, binary and XML" << std::endl
+              << "  micro [--filter dsp/block] [--repeats 7] [--seconds 10] [--json results.json]" << std::endl
+              << "      processBlock in ns/sample across the settings, automation and curve costs" << std::endl
+              << "  session [--instances 500] [--seconds 30] [--block 512] [--rate 48000] [--automated 25] [--json results.json]" << std::endl
+              << "      a session of instances processed in turn per callback: p50/p99/max, load, memory, restore" << std::endl
+              << "  audit [--seconds 5] [--block 512] [--filter automation]" << std::endl
+              << "      audit builds only: fails if the audio thread allocates, locks or blocks" << std::endl
+              << "  stress [--seconds 10] [--block 64]" << std::endl
+              << "      transactions, automation and curve reads against processBlock; run the TSan build for data races" << std::endl
+              << "  compare <baseline.json> <current.json> [--threshold 5]" << std::endl
+              << "      lists the changes between two runs and fails on regressions above the threshold in %" << std::endl;
+
+    return 1;
+}
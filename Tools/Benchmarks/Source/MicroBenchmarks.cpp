@@ -0,0 +1,391 @@
+/*
+  ==============================================================================
+
+    MicroBenchmarks.cpp
+    The DSP hot path, parameter automation and the response curve, one at a time.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "BenchmarkResults.h"
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/PluginEditor.h"
+
+namespace Benchmarks
+{
+    namespace
+    {
+        using ParameterValues = SimpleEQAudioProcessor::ParameterValues;
+
+        struct Settings
+        {
+            int repeats = 7;
+            int seconds = 10;   // audio per repeat
+            juce::String filter;
+
+            // The filter is a prefix of the names to run, e.g. "dsp/block" or "curve"
+            bool selects (const juce::String& name) const  { return name.startsWith (filter) || filter.startsWith (name); }
+        };
+
+        /** One processor configuration to time processBlock with. */
+        struct DspCase
+        {
+            juce::String name;
+            double sampleRate = 48000.0;
+            int blockSize = 512;
+            int numChannels = 2;
+            bool doublePrecision = false;
+            ParameterValues parameters;
+        };
+
+        // Six bands at musical settings, all active; what a typical instance pays for
+        ParameterValues getActiveBands (int mask = 0x3f)
+        {
+            ParameterValues values;
+
+            for (int band = 0; band < 6; ++band)
+            {
+                const auto suffix = juce::String (band + 1);
+                values["Bypass" + suffix] = (mask & (1 << band)) != 0 ? 0.0f : 1.0f;
+                values["Gain" + suffix] = 3.0f;
+                values["Q" + suffix] = 1.0f;
+            }
+
+            return values;
+        }
+
+        ParameterValues with (ParameterValues values, const ParameterValues& changes)
+        {
+            for (const auto& [parameterID, value] : changes)
+                values[parameterID] = value;
+
+            return values;
+        }
+
+        double getMedian (std::vector<double> values)
+        {
+            std::sort (values.begin(), values.end());
+            return values[values.size() / 2];
+        }
+
+        std::unique_ptr<SimpleEQAudioProcessor> createProcessor (const DspCase& dspCase)
+        {
+            auto processor = std::make_unique<SimpleEQAudioProcessor>();
+            processor->applyParameterValues (dspCase.parameters);
+
+            const auto channelSet = juce::AudioChannelSet::canonicalChannelSet (dspCase.numChannels);
+            juce::AudioProcessor::BusesLayout layout;
+            layout.inputBuses.add (channelSet);
+            layout.outputBuses.add (channelSet);
+
+            if (! processor->setBusesLayout (layout))
+                return {};
+
+            processor->setProcessingPrecision (dspCase.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                       : juce::AudioProcessor::singlePrecision);
+            processor->setRateAndBufferSizeDetails (dspCase.sampleRate, dspCase.blockSize);
+            // In linear phase this installs the kernel for the case's parameters before it returns
+            processor->prepareToPlay (dspCase.sampleRate, dspCase.blockSize);
+
+            return processor;
+        }
+
+        /** Runs noise through the processor a block at a time and returns the median cost in ns
+            per sample frame. beforeBlock is timed along with the block, as a host's automation is.
+        */
+        template <typename SampleType>
+        double timeProcessing (SimpleEQAudioProcessor& processor, const DspCase& dspCase, const Settings& settings,
+                               const std::function<void (int)>& beforeBlock = {})
+        {
+            const auto numChannels = dspCase.numChannels;
+            const auto blockSize = dspCase.blockSize;
+            const auto length = juce::jmax (blockSize, (int) dspCase.sampleRate) / blockSize * blockSize;
+
+            // A second of noise at -12 dBFS, copied fresh for every pass so the bands never
+            // pile their gain up
+            juce::AudioBuffer<SampleType> source (numChannels, length), work (numChannels, length);
+            juce::Random random (0x5eed);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < length; ++i)
+                    source.setSample (channel, i, (SampleType) ((random.nextFloat() * 2.0f - 1.0f) * 0.25f));
+
+            juce::MidiBuffer midi;
+            std::vector<double> costs;
+            auto blockIndex = 0;
+
+            // The first round only warms up caches and branch predictors
+            for (int repeat = -1; repeat < settings.repeats; ++repeat)
+            {
+                juce::int64 ticks = 0, frames = 0;
+
+                for (int pass = 0; pass < settings.seconds; ++pass)
+                {
+                    work.makeCopyOf (source, true);
+
+                    // Timed per pass rather than per block, so the clock costs nothing even at 16 samples
+                    const auto start = juce::Time::getHighResolutionTicks();
+
+                    for (int offset = 0; offset < length; offset += blockSize)
+                    {
+                        juce::AudioBuffer<SampleType> block (work.getArrayOfWritePointers(), numChannels, offset, blockSize);
+
+                        if (beforeBlock != nullptr)
+                            beforeBlock (blockIndex++);
+
+                        processor.processBlock (block, midi);
+                    }
+
+                    ticks += juce::Time::getHighResolutionTicks() - start;
+                    frames += length;
+                }
+
+                if (repeat >= 0)
+                    costs.push_back (1.0e9 * juce::Time::highResolutionTicksToSeconds (ticks) / (double) frames);
+            }
+
+            return getMedian (costs);
+        }
+
+        double runDspCase (const DspCase& dspCase, const Settings& settings, const std::function<void (int)>& beforeBlock = {})
+        {
+            auto processor = createProcessor (dspCase);
+
+            if (processor == nullptr)
+                return -1.0;
+
+            return dspCase.doublePrecision ? timeProcessing<double> (*processor, dspCase, settings, beforeBlock)
+                                           : timeProcessing<float> (*processor, dspCase, settings, beforeBlock);
+        }
+
+        void report (Results& results, const juce::String& name, double value, const juce::String& unit)
+        {
+            if (value < 0.0)
+            {
+                std::cout << name.paddedRight (' ', 40) << "unsupported" << std::endl;
+                return;
+            }
+
+            results.add (name, value, unit);
+            std::cout << name.paddedRight (' ', 40) << juce::String (value, 2) << " " << unit << std::endl;
+        }
+
+        //==============================================================================
+        std::vector<DspCase> getDspCases()
+        {
+            std::vector<DspCase> cases;
+            const auto allBands = getActiveBands();
+
+            for (auto blockSize : { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 })
+                cases.push_back ({ "dsp/block/" + juce::String (blockSize), 48000.0, blockSize, 2, false, allBands });
+
+            for (auto sampleRate : { 44100, 48000, 88200, 96000, 176400, 192000 })
+                cases.push_back ({ "dsp/rate/" + juce::String (sampleRate), (double) sampleRate, 512, 2, false, allBands });
+
+            for (int numBands = 0; numBands <= 6; ++numBands)
+                cases.push_back ({ "dsp/bands/" + juce::String (numBands), 48000.0, 512, 2, false, getActiveBands ((1 << numBands) - 1) });
+
+            // Band 3 takes any type; the two outer bands are fixed cuts
+            const juce::StringArray typeNames { "lowcut", "highcut", "bell", "notch", "bandpass" };
+
+            for (int type = 0; type < typeNames.size(); ++type)
+                cases.push_back ({ "dsp/type/" + typeNames[type], 48000.0, 512, 2, false,
+                                   with (getActiveBands (1 << 2), { { "Type3", (float) type } }) });
+
+            for (int mask = 0; mask < 64; ++mask)
+            {
+                juce::String pattern;
+
+                for (int band = 0; band < 6; ++band)
+                    pattern << ((mask & (1 << band)) != 0 ? "1" : "0");
+
+                cases.push_back ({ "dsp/bypass/" + pattern, 48000.0, 512, 2, false, getActiveBands (mask) });
+            }
+
+            // The precision variants: float, float I/O with double state, and a double host
+            cases.push_back ({ "dsp/precision/float", 48000.0, 512, 2, false, allBands });
+            cases.push_back ({ "dsp/precision/doublestate", 48000.0, 512, 2, false, with (allBands, { { "Precision", 1.0f } }) });
+            cases.push_back ({ "dsp/precision/double", 48000.0, 512, 2, true, allBands });
+
+            for (int factor = 1; factor <= 3; ++factor)
+                cases.push_back ({ "dsp/oversampling/" + juce::String (1 << factor) + "x", 48000.0, 512, 2, false,
+                                   with (allBands, { { "Oversampling", (float) factor } }) });
+
+            const juce::StringArray qualities { "low", "medium", "high" };
+
+            for (int quality = 0; quality < qualities.size(); ++quality)
+                cases.push_back ({ "dsp/linearphase/" + qualities[quality], 48000.0, 512, 2, false,
+                                   with (allBands, { { "PhaseMode", 1.0f }, { "LinearPhaseQuality", (float) quality } }) });
+
+            const std::pair<const char*, int> layouts[] { { "mono", 1 }, { "stereo", 2 }, { "lcr", 3 },
+                                                          { "5.1", 6 }, { "7.1", 8 }, { "7.1.4", 12 } };
+
+            for (const auto& [layoutName, numChannels] : layouts)
+                cases.push_back ({ juce::String ("dsp/layout/") + layoutName, 48000.0, 512, numChannels, false, allBands });
+
+            cases.push_back ({ "dsp/layout/7.1.4/multicore", 48000.0, 512, 12, false, with (allBands, { { "Multicore", 1.0f } }) });
+
+            return cases;
+        }
+
+        void runDspBenchmarks (Results& results, const Settings& settings)
+        {
+            for (const auto& dspCase : getDspCases())
+                if (dspCase.name.startsWith (settings.filter))
+                    report (results, dspCase.name, runDspCase (dspCase, settings), "ns/sample");
+        }
+
+        //==============================================================================
+        // Host automation at a small block size: every block moves the frequency of some
+        // bands, so updateFilterSetup redesigns them before the block runs
+        void runAutomationBenchmarks (Results& results, const Settings& settings)
+        {
+            if (! settings.selects ("automation"))
+                return;
+
+            constexpr int blockSize = 64;
+            const DspCase base { "automation", 48000.0, blockSize, 2, false, getActiveBands() };
+
+            // What the host side of one change costs on its own
+            {
+                SimpleEQAudioProcessor processor;
+                auto* parameter = processor.apvts.getParameter ("Freq3");
+                constexpr int numCalls = 100000;
+
+                const auto start = juce::Time::getHighResolutionTicks();
+
+                for (int i = 0; i < numCalls; ++i)
+                    parameter->setValueNotifyingHost ((float) (i & 1023) / 1023.0f);
+
+                report (results, "automation/setvalue",
+                        1.0e9 * juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) / numCalls, "ns/call");
+            }
+
+            const auto staticCost = runDspCase (base, settings) * blockSize;
+            report (results, "automation/static", staticCost, "ns/block");
+
+            for (auto numBands : { 1, 6 })
+            {
+                for (auto smoothing : { 0, 2 })
+                {
+                    auto automated = base;
+                    automated.parameters["SmoothingBlock"] = (float) smoothing;
+
+                    auto processor = createProcessor (automated);
+
+                    std::array<juce::RangedAudioParameter*, 6> frequencies {};
+
+                    for (int band = 0; band < 6; ++band)
+                        frequencies[(size_t) band] = processor->apvts.getParameter ("Freq" + juce::String (band + 1));
+
+                    // A slow sweep, stepped every block, like drawn automation
+                    const auto cost = timeProcessing<float> (*processor, automated, settings, [&] (int block)
+                    {
+                        const auto position = 0.3f + 0.2f * std::sin ((float) block * 0.01f);
+
+                        for (int band = 0; band < numBands; ++band)
+                            frequencies[(size_t) band]->setValueNotifyingHost (position);
+                    }) * blockSize;
+
+                    const auto name = "automation/" + juce::String (numBands) + (numBands == 1 ? "band" : "bands")
+                                    + (smoothing == 0 ? "/jump" : "/smoothed");
+
+                    report (results, name, cost, "ns/block");
+
+                    // Everything above the static cost is the host call plus the redesign. A cheap
+                    // change can vanish in the noise of the two timings; it is then reported as free
+                    // rather than as a negative cost that no comparison could make sense of
+                    report (results, name + "/perchange", juce::jmax (0.0, cost - staticCost) / numBands, "ns/change");
+                }
+            }
+        }
+
+        //==============================================================================
+        void runCurveBenchmarks (Results& results, const Settings& settings)
+        {
+            if (! settings.selects ("curve"))
+                return;
+
+            const DspCase setup { "curve", 48000.0, 512, 2, false, getActiveBands() };
+            auto processor = createProcessor (setup);
+
+            // One block publishes the setup the curve reads
+            juce::AudioBuffer<float> buffer (2, setup.blockSize);
+            juce::MidiBuffer midi;
+            buffer.clear();
+            processor->processBlock (buffer, midi);
+
+            ResponseCurveComponent curve (*processor);
+            auto* gain = processor->apvts.getParameter ("Gain3");
+            constexpr int numCalls = 200;
+
+            for (auto width : { 200, 400, 800, 1600, 3200 })
+            {
+                // The plot is 40 pixels narrower than the component
+                curve.setSize (width + 40, 300);
+
+                std::vector<double> cached, changed;
+
+                for (int repeat = 0; repeat < settings.repeats; ++repeat)
+                {
+                    auto start = juce::Time::getHighResolutionTicks();
+
+                    for (int i = 0; i < numCalls; ++i)
+                        curve.updateResponseCurve();
+
+                    cached.push_back (1.0e6 * juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) / numCalls);
+
+                    // One band moved: the setup is read again, that band and the curve are
+                    // recomputed and the layers are handed to the renderer thread
+                    juce::int64 ticks = 0;
+
+                    for (int i = 0; i < numCalls; ++i)
+                    {
+                        gain->setValueNotifyingHost ((i & 1) != 0 ? 0.6f : 0.4f);
+                        processor->processBlock (buffer, midi);
+
+                        start = juce::Time::getHighResolutionTicks();
+                        curve.resized();
+                        ticks += juce::Time::getHighResolutionTicks() - start;
+                    }
+
+                    changed.push_back (1.0e6 * juce::Time::highResolutionTicksToSeconds (ticks) / numCalls);
+                }
+
+                report (results, "curve/" + juce::String (width) + "/cached", getMedian (cached), "us/update");
+                report (results, "curve/" + juce::String (width) + "/changed", getMedian (changed), "us/update");
+            }
+        }
+    }
+
+    //==============================================================================
+    int runMicroBenchmarks (const juce::StringArray& args)
+    {
+        Settings settings;
+        settings.repeats = juce::jmax (1, getIntOption (args, "--repeats", settings.repeats));
+        settings.seconds = juce::jmax (1, getIntOption (args, "--seconds", settings.seconds));
+        settings.filter = getStringOption (args, "--filter", {});
+
+        Results results;
+
+        runDspBenchmarks (results, settings);
+        runAutomationBenchmarks (results, settings);
+        runCurveBenchmarks (results, settings);
+
+        const auto jsonPath = getStringOption (args, "--json", {});
+
+        if (jsonPath.isNotEmpty())
+        {
+            const auto file = juce::File::getCurrentWorkingDirectory().getChildFile (jsonPath);
+
+            if (! file.replaceWithText (results.toJson()))
+            {
+                std::cout << "error: could not write " << file.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+}
@@ -0,0 +1,261 @@
+/*
+  ==============================================================================
+
+    SessionBenchmark.cpp
+    A whole session: hundreds of instances, processed round-robin like a host.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "BenchmarkResults.h"
+#include "../../../Source/PluginProcessor.h"
+#include <numeric>
+
+#if JUCE_LINUX
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#elif JUCE_WINDOWS
+ #include <windows.h>
+ #include <psapi.h>
+ #pragma comment (lib, "psapi.lib")
+#endif
+
+namespace Benchmarks
+{
+    namespace
+    {
+        /** Resident memory of the whole process in bytes, or 0 where unknown. */
+        juce::int64 getResidentBytes()
+        {
+           #if JUCE_LINUX
+            const auto fields = juce::StringArray::fromTokens (juce::File ("/proc/self/statm").loadFileAsString(), false);
+            return fields.size() > 1 ? fields[1].getLargeIntValue() * (juce::int64) sysconf (_SC_PAGESIZE) : 0;
+           #elif JUCE_MAC
+            mach_task_basic_info info {};
+            mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+            if (task_info (mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS)
+                return 0;
+
+            return (juce::int64) info.resident_size;
+           #elif JUCE_WINDOWS
+            PROCESS_MEMORY_COUNTERS counters {};
+
+            if (! GetProcessMemoryInfo (GetCurrentProcess(), &counters, sizeof (counters)))
+                return 0;
+
+            return (juce::int64) counters.WorkingSetSize;
+           #else
+            return 0;
+           #endif
+        }
+
+        double getPercentile (const std::vector<double>& sorted, double fraction)
+        {
+            const auto index = juce::jlimit ((size_t) 0, sorted.size() - 1, (size_t) (fraction * (double) (sorted.size() - 1) + 0.5));
+            return sorted[index];
+        }
+
+        /** Every track gets its own mix: two to six bands at random settings. */
+        SimpleEQAudioProcessor::ParameterValues createTrackSettings (juce::Random& random)
+        {
+            SimpleEQAudioProcessor::ParameterValues values;
+            const auto numActive = random.nextInt ({ 2, 7 });
+
+            for (int band = 0; band < 6; ++band)
+            {
+                const auto suffix = juce::String (band + 1);
+                values["Bypass" + suffix] = band < numActive ? 0.0f : 1.0f;
+                values["Freq" + suffix] = 40.0f * std::pow (400.0f, random.nextFloat());
+                values["Gain" + suffix] = random.nextFloat() * 18.0f - 9.0f;
+                values["Q" + suffix] = 0.3f + random.nextFloat() * 3.0f;
+
+                if (band > 0 && band < 5)
+                    values["Type" + suffix] = (float) (random.nextInt (4) == 0 ? random.nextInt (5) : 2);
+            }
+
+            return values;
+        }
+
+        /** A track the host automates: two parameters follow slow LFOs of their own. */
+        struct Automation
+        {
+            juce::RangedAudioParameter* gain = nullptr;
+            juce::RangedAudioParameter* frequency = nullptr;
+            float phase = 0.0f, rate = 0.0f;
+        };
+    }
+
+    int runSessionBenchmark (const juce::StringArray& args)
+    {
+        const auto numInstances = juce::jmax (1, getIntOption (args, "--instances", 500));
+        const auto seconds = juce::jmax (1, getIntOption (args, "--seconds", 30));
+        const auto blockSize = juce::jmax (16, getIntOption (args, "--block", 512));
+        const auto sampleRate = (double) juce::jmax (8000, getIntOption (args, "--rate", 48000));
+        const auto automatedPercent = juce::jlimit (0, 100, getIntOption (args, "--automated", 25));
+
+        Results results;
+        const auto report = [&results] (const juce::String& name, double value, const juce::String& unit)
+        {
+            results.add (name, value, unit);
+            std::cout << name.paddedRight (' ', 32) << juce::String (value, 2) << " " << unit << std::endl;
+        };
+
+        std::cout << numInstances << " instances, " << blockSize << " samples at " << sampleRate / 1000.0 << " kHz, "
+                  << automatedPercent << "% automated, " << seconds << " s" << std::endl << std::endl;
+
+        // Instantiation, and the memory the instances take before and after prepare
+        const auto residentAtStart = getResidentBytes();
+        juce::OwnedArray<SimpleEQAudioProcessor> instances;
+
+        auto start = juce::Time::getMillisecondCounterHiRes();
+
+        for (int i = 0; i < numInstances; ++i)
+            instances.add (new SimpleEQAudioProcessor());
+
+        report ("session/instantiate", (juce::Time::getMillisecondCounterHiRes() - start) * 1000.0 / numInstances, "us/instance");
+
+        const auto residentCreated = getResidentBytes();
+
+        start = juce::Time::getMillisecondCounterHiRes();
+
+        for (auto* instance : instances)
+        {
+            instance->setRateAndBufferSizeDetails (sampleRate, blockSize);
+            instance->prepareToPlay (sampleRate, blockSize);
+        }
+
+        report ("session/prepare", (juce::Time::getMillisecondCounterHiRes() - start) * 1000.0 / numInstances, "us/instance");
+
+        const auto residentPrepared = getResidentBytes();
+
+        if (residentAtStart > 0)
+        {
+            report ("session/memory/created", (double) (residentCreated - residentAtStart) / 1024.0 / numInstances, "KiB/instance");
+            report ("session/memory/prepared", (double) (residentPrepared - residentAtStart) / 1024.0 / numInstances, "KiB/instance");
+        }
+
+        // Session load: every track's own state restored into it, as a host opening the project
+        juce::Random random (0x5e55);
+        std::vector<juce::MemoryBlock> states ((size_t) numInstances);
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            SimpleEQAudioProcessor track;
+            track.applyParameterValues (createTrackSettings (random));
+            track.getStateInformation (states[(size_t) i]);
+        }
+
+        start = juce::Time::getMillisecondCounterHiRes();
+
+        for (int i = 0; i < numInstances; ++i)
+            instances[i]->setStateInformation (states[(size_t) i].getData(), (int) states[(size_t) i].getSize());
+
+        report ("session/restore", (juce::Time::getMillisecondCounterHiRes() - start) * 1000.0 / numInstances, "us/instance");
+
+        // One stereo buffer per track; the inputs are refreshed from a bed of noise before
+        // each callback, outside the timing, as a host's inputs would already be there
+        const auto noiseLength = (int) sampleRate;
+        juce::AudioBuffer<float> noise (2, noiseLength);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < noiseLength; ++i)
+                noise.setSample (channel, i, (random.nextFloat() * 2.0f - 1.0f) * 0.25f);
+
+        std::vector<juce::AudioBuffer<float>> buffers ((size_t) numInstances, juce::AudioBuffer<float> (2, blockSize));
+        std::vector<Automation> automation;
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            if (random.nextInt (100) >= automatedPercent)
+                continue;
+
+            auto& apvts = instances[i]->apvts;
+            automation.push_back ({ apvts.getParameter ("Gain2"), apvts.getParameter ("Freq3"),
+                                    random.nextFloat() * juce::MathConstants<float>::twoPi,
+                                    (0.05f + random.nextFloat() * 0.5f) * juce::MathConstants<float>::twoPi * (float) blockSize / (float) sampleRate });
+        }
+
+        const auto numCallbacks = (int) (seconds * sampleRate / blockSize);
+        const auto callbackPeriodMs = 1000.0 * blockSize / sampleRate;
+
+        std::vector<double> callbackMs;
+        callbackMs.reserve ((size_t) numCallbacks);
+
+        juce::MidiBuffer midi;
+        auto noisePosition = 0;
+        auto numOverruns = 0;
+
+        const auto cpuStart = std::clock();
+        const auto wallStart = juce::Time::getMillisecondCounterHiRes();
+
+        for (int callback = 0; callback < numCallbacks; ++callback)
+        {
+            if (noisePosition + blockSize > noiseLength)
+                noisePosition = 0;
+
+            for (auto& buffer : buffers)
+                for (int channel = 0; channel < 2; ++channel)
+                    buffer.copyFrom (channel, 0, noise, channel, noisePosition, blockSize);
+
+            noisePosition += blockSize;
+
+            const auto callbackStart = juce::Time::getHighResolutionTicks();
+
+            // Parameter changes reach the instances at the start of the callback, then every
+            // track is processed in turn
+            for (auto& track : automation)
+            {
+                const auto phase = track.phase + track.rate * (float) callback;
+                track.gain->setValueNotifyingHost (0.5f + 0.3f * std::sin (phase));
+                track.frequency->setValueNotifyingHost (0.3f + 0.2f * std::sin (0.7f * phase));
+            }
+
+            for (int i = 0; i < numInstances; ++i)
+                instances[i]->processBlock (buffers[(size_t) i], midi);
+
+            const auto elapsedMs = 1000.0 * juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - callbackStart);
+            callbackMs.push_back (elapsedMs);
+
+            if (elapsedMs > callbackPeriodMs)
+                ++numOverruns;
+        }
+
+        const auto wallSeconds = (juce::Time::getMillisecondCounterHiRes() - wallStart) / 1000.0;
+        const auto cpuSeconds = (double) (std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+        std::sort (callbackMs.begin(), callbackMs.end());
+        const auto totalMs = std::accumulate (callbackMs.begin(), callbackMs.end(), 0.0);
+
+        // Load is the share of each callback period the session took on the one thread it runs on
+        report ("session/load", 100.0 * totalMs / (numCallbacks * callbackPeriodMs), "% of realtime");
+        report ("session/cpu", 100.0 * cpuSeconds / juce::jmax (wallSeconds, 1.0e-9), "% of a core");
+        report ("session/callback/p50", getPercentile (callbackMs, 0.5) * 1000.0, "us");
+        report ("session/callback/p99", getPercentile (callbackMs, 0.99) * 1000.0, "us");
+        report ("session/callback/max", callbackMs.back() * 1000.0, "us");
+        report ("session/perinstance", totalMs * 1.0e6 / ((double) numCallbacks * numInstances * blockSize), "ns/sample");
+
+        std::cout << std::endl << numOverruns << " of " << numCallbacks << " callbacks took longer than their "
+                  << juce::String (callbackPeriodMs, 2) << " ms period" << std::endl;
+
+        for (auto* instance : instances)
+            instance->releaseResources();
+
+        const auto jsonPath = getStringOption (args, "--json", {});
+
+        if (jsonPath.isNotEmpty())
+        {
+            const auto file = juce::File::getCurrentWorkingDirectory().getChildFile (jsonPath);
+
+            if (! file.replaceWithText (results.toJson()))
+            {
+                std::cout << "error: could not write " << file.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+}
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    StateBenchmark.cpp
+    Session load: one saved state restored into hundreds of instances.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "../../../Source/PluginProcessor.h"
+
+namespace Benchmarks
+{
+    namespace
+    {
+        // Every parameter somewhere else in its range, so a restore has to change all of them
+        void randomiseParameters (SimpleEQAudioProcessor& processor, juce::Random& random)
+        {
+            for (auto* parameter : processor.getParameters())
+                parameter->setValueNotifyingHost (random.nextFloat());
+        }
+
+        bool parametersMatch (SimpleEQAudioProcessor& a, SimpleEQAudioProcessor& b)
+        {
+            const auto& parametersA = a.getParameters();
+            const auto& parametersB = b.getParameters();
+
+            for (int i = 0; i < parametersA.size(); ++i)
+                if (std::abs (parametersA[i]->getValue() - parametersB[i]->getValue()) > 1.0e-6f)
+                    return false;
+
+            return true;
+        }
+
+        template <typename RestoreFunction>
+        double timeRestores (juce::OwnedArray<SimpleEQAudioProcessor>& instances, int repeats, RestoreFunction&& restore)
+        {
+            std::vector<double> totals;
+
+            for (int repeat = 0; repeat < repeats; ++repeat)
+            {
+                const auto start = juce::Time::getMillisecondCounterHiRes();
+
+                for (auto* instance : instances)
+                    restore (*instance, repeat);
+
+                totals.push_back (juce::Time::getMillisecondCounterHiRes() - start);
+            }
+
+            std::sort (totals.begin(), totals.end());
+            return totals[totals.size() / 2];
+        }
+    }
+
+    int runStateBenchmark (const juce::StringArray& args)
+    {
+        const auto numInstances = juce::jmax (1, getIntOption (args, "--instances", 500));
+        const auto repeats = juce::jmax (1, getIntOption (args, "--repeats", 5));
+
+        // Two different states, alternated so that every restore really changes every parameter
+        juce::Random random (0x5eed);
+        SimpleEQAudioProcessor reference;
+        std::array<juce::MemoryBlock, 2> binaryStates, xmlStates;
+
+        for (size_t i = 0; i < binaryStates.size(); ++i)
+        {
+            randomiseParameters (reference, random);
+            reference.getStateInformation (binaryStates[i]);
+
+            const auto xml = reference.apvts.copyState().createXml();
+            juce::AudioProcessor::copyXmlToBinary (*xml, xmlStates[i]);
+        }
+
+        const auto createStart = juce::Time::getMillisecondCounterHiRes();
+        juce::OwnedArray<SimpleEQAudioProcessor> instances;
+
+        for (int i = 0; i < numInstances; ++i)
+            instances.add (new SimpleEQAudioProcessor());
+
+        const auto createMs = juce::Time::getMillisecondCounterHiRes() - createStart;
+
+        const auto binaryMs = timeRestores (instances, repeats, [&] (SimpleEQAudioProcessor& instance, int repeat)
+        {
+            const auto& state = binaryStates[(size_t) repeat % 2];
+            instance.setStateInformation (state.getData(), (int) state.getSize());
+        });
+
+        // Round trip: the reference still holds the second state
+        instances.getFirst()->setStateInformation (binaryStates[1].getData(), (int) binaryStates[1].getSize());
+
+        if (! parametersMatch (*instances.getFirst(), reference))
+        {
+            std::cout << "error: restored parameters differ from the saved ones" << std::endl;
+            return 1;
+        }
+
+        const auto xmlMs = timeRestores (instances, repeats, [&] (SimpleEQAudioProcessor& instance, int repeat)
+        {
+            const auto& state = xmlStates[(size_t) repeat % 2];
+
+            if (auto xml = juce::AudioProcessor::getXmlFromBinary (state.getData(), (int) state.getSize()))
+                instance.apvts.replaceState (juce::ValueTree::fromXml (*xml));
+        });
+
+        std::cout << "instances:          " << numInstances << std::endl
+                  << "instantiation:      " << juce::String (createMs, 1) << " ms" << std::endl
+                  << "binary state:       " << binaryStates[0].getSize() << " bytes, "
+                  << juce::String (binaryMs, 2) << " ms per session, "
+                  << juce::String (1000.0 * binaryMs / numInstances, 1) << " us per instance" << std::endl
+                  << "XML state:          " << xmlStates[0].getSize() << " bytes, "
+                  << juce::String (xmlMs, 2) << " ms per session, "
+                  << juce::String (1000.0 * xmlMs / numInstances, 1) << " us per instance" << std::endl;
+
+        return 0;
+    }
+}
@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+    StressTest.cpp
+    Transactions, host automation and the editor's reads racing processBlock.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/BiquadDesigner.h"
+
+namespace Benchmarks
+{
+    namespace
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numStamps = 1000;
+
+        /** Runs the body over and over, as fast as it goes, until told to stop. */
+        class LoopThread  : public juce::Thread
+        {
+        public:
+            LoopThread (const juce::String& name, std::function<void()> bodyToUse)
+                : juce::Thread (name), body (std::move (bodyToUse))
+            {
+            }
+
+            void run() override
+            {
+                while (! threadShouldExit())
+                {
+                    body();
+                    iterations.store (iterations.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                }
+            }
+
+            juce::int64 getIterations() const noexcept      { return iterations.load (std::memory_order_relaxed); }
+
+        private:
+            std::function<void()> body;
+            std::atomic<juce::int64> iterations { 0 };
+        };
+
+        /** Transaction number k, stamped into the frequency, Q and gain of every band alike.
+            All values sit on the parameters' steps, so they come back exactly as written.
+        */
+        float getStampFrequency (int k)     { return 100.0f + 10.0f * (float) k; }
+        float getStampQ (int k)             { return 0.5f + 0.1f * (float) (k % 40); }
+        float getStampGain (int k)          { return -10.0f + 0.1f * (float) (k % 200); }
+
+        SimpleEQAudioProcessor::ParameterValues createStampedValues (int k)
+        {
+            SimpleEQAudioProcessor::ParameterValues values;
+
+            for (int band = 1; band <= 6; ++band)
+            {
+                const auto suffix = juce::String (band);
+                values["Freq" + suffix] = getStampFrequency (k);
+                values["Q" + suffix] = getStampQ (k);
+                values["Gain" + suffix] = getStampGain (k);
+            }
+
+            return values;
+        }
+
+        /** Empty if the setup is whole, otherwise what is wrong with it. A setup mixing two
+            transactions means the seqlock let a torn read through; coefficients that don't
+            belong to their parameters mean the triple buffer handed over a slot mid-write.
+        */
+        juce::String checkSetup (const Dsp::FilterSetup& setup)
+        {
+            const auto k = juce::roundToInt ((setup.parameters[0].frequency - getStampFrequency (0)) / 10.0f);
+
+            for (size_t band = 0; band < (size_t) Dsp::FilterSetup::numBands; ++band)
+            {
+                const auto& parameters = setup.parameters[band];
+                const auto hasGain = band > 0 && band < (size_t) Dsp::FilterSetup::numBands - 1;
+
+                if (std::abs (parameters.frequency - getStampFrequency (k)) > 1.0e-2f
+                     || std::abs (parameters.q - getStampQ (k)) > 1.0e-3f
+                     || (hasGain && std::abs (juce::Decibels::gainToDecibels (parameters.gain) - getStampGain (k)) > 1.0e-3f))
+                    return "band " + juce::String (band + 1) + " is not from the same transaction as band 1";
+
+                Dsp::BiquadCoefficients expected;
+                Dsp::BiquadDesigner::design (parameters, setup.method, setup.sampleRate, expected);
+
+                if (expected != setup.coefficients[band])
+                    return "band " + juce::String (band + 1) + " has coefficients of other parameters";
+            }
+
+            return {};
+        }
+    }
+
+    int runStressTest (const juce::StringArray& args)
+    {
+        const auto seconds = juce::jmax (1, getIntOption (args, "--seconds", 10));
+        const auto blockSize = juce::jmax (16, getIntOption (args, "--block", 64));
+
+        SimpleEQAudioProcessor processor;
+
+        // Every setup the audio thread publishes, the first included, must carry one stamp
+        processor.applyParameterValues (createStampedValues (0));
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random noise (0x57e55);
+
+        // The host's audio callback, without any pacing so that it races the others flat out
+        LoopThread audioThread ("EQ stress audio", [&]
+        {
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (channel, i, noise.nextFloat() * 0.5f - 0.25f);
+
+            processor.processBlock (buffer, midi);
+        });
+
+        // Preset loads and state restores: one transaction after another, each a new stamp
+        auto stamp = 0;
+
+        LoopThread transactionThread ("EQ stress transactions", [&]
+        {
+            stamp = (stamp + 1) % numStamps;
+            processor.applyParameterValues (createStampedValues (stamp));
+        });
+
+        // Host automation outside the transactions, on everything the stamp leaves alone
+        juce::Random automation (0xa5709);
+        juce::Array<juce::RangedAudioParameter*> automated;
+
+        for (int band = 1; band <= 6; ++band)
+        {
+            automated.add (processor.apvts.getParameter ("Bypass" + juce::String (band)));
+
+            if (band > 1 && band < 6)
+                automated.add (processor.apvts.getParameter ("Type" + juce::String (band)));
+        }
+
+        automated.add (processor.apvts.getParameter ("Gain"));
+        automated.add (processor.apvts.getParameter ("Scale"));
+
+        LoopThread hostThread ("EQ stress automation", [&]
+        {
+            automated[automation.nextInt (automated.size())]->setValueNotifyingHost (automation.nextFloat());
+        });
+
+        audioThread.startThread (juce::Thread::Priority::highest);
+        transactionThread.startThread();
+        hostThread.startThread();
+
+        // This thread is the editor: it reads every setup the audio thread hands over
+        const auto end = juce::Time::getMillisecondCounter() + (juce::uint32) (1000 * seconds);
+        juce::int64 numSetups = 0, numReads = 0;
+        juce::StringArray failures;
+        Dsp::FilterSetup setup;
+
+        while (juce::Time::getMillisecondCounter() < end && failures.size() < 10)
+        {
+            ++numReads;
+
+            if (! processor.getLatestFilterSetup (setup))
+                continue;
+
+            ++numSetups;
+            const auto failure = checkSetup (setup);
+
+            if (failure.isNotEmpty())
+                failures.add (failure);
+        }
+
+        hostThread.stopThread (2000);
+        transactionThread.stopThread (2000);
+        audioThread.stopThread (2000);
+        processor.releaseResources();
+
+        std::cout << "blocks:             " << audioThread.getIterations() << std::endl
+                  << "transactions:       " << transactionThread.getIterations() << std::endl
+                  << "automation changes: " << hostThread.getIterations() << std::endl
+                  << "setups checked:     " << numSetups << " of " << numReads << " reads" << std::endl;
+
+        for (const auto& failure : failures)
+            std::cout << "torn setup: " << failure << std::endl;
+
+        std::cout << std::endl << (failures.isEmpty() ? "passed: every setup came from one complete transaction"
+                                                      : "failed: the editor saw a setup that was never applied whole")
+                  << std::endl;
+
+        return failures.isEmpty() ? 0 : 1;
+    }
+}
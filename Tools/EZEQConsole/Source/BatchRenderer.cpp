@@ -0,0 +1,251 @@
+/*
+  ==============================================================================
+
+    BatchRenderer.cpp
+    Offline rendering of audio files through the EQ, one processor per worker.
+
+  ==============================================================================
+*/
+
+#include "BatchRenderer.h"
+
+namespace Console
+{
+    namespace
+    {
+        FileReport failed (FileReport report, const juce::String& error)
+        {
+            report.error = error;
+            return report;
+        }
+
+        int pickBitDepth (juce::AudioFormat& format, int sourceBits)
+        {
+            const auto depths = format.getPossibleBitDepths();
+
+            if (depths.contains (sourceBits))
+                return sourceBits;
+
+            // FLAC stops at 24 bit; take the deepest the format has
+            return depths.isEmpty() ? sourceBits : depths.getLast();
+        }
+    }
+
+    //==============================================================================
+    void applyOptions (SimpleEQAudioProcessor& processor, const RenderOptions& options)
+    {
+        if (options.preset.isValid())
+            processor.applyParameterState (options.preset);
+
+        processor.applyParameterValues (options.parameters);
+        processor.setNonRealtime (true);
+    }
+
+    juce::Result prepareProcessor (SimpleEQAudioProcessor& processor, int numChannels, double sampleRate, int blockSize)
+    {
+        const auto channelSet = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (channelSet);
+        layout.outputBuses.add (channelSet);
+
+        if (channelSet.isDisabled() || ! processor.setBusesLayout (layout))
+            return juce::Result::fail (juce::String (numChannels) + " channels is not a layout the EQ supports");
+
+        // Hosted like a 64 bit host, so everything runs on the double chain; the files
+        // themselves are 32 bit at most
+        processor.setProcessingPrecision (juce::AudioProcessor::doublePrecision);
+        // The options are applied by now, so in linear phase prepareToPlay() installs the
+        // kernel for them before it returns and the first block is already filtered
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        return juce::Result::ok();
+    }
+
+    juce::File getOutputFile (const RenderOptions& options, const juce::File& input)
+    {
+        const auto directory = options.outputDirectory != juce::File() ? options.outputDirectory
+                                                                       : input.getParentDirectory();
+
+        return directory.getChildFile (input.getFileNameWithoutExtension() + options.suffix + input.getFileExtension());
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> createWriter (juce::AudioFormat& format, const juce::File& file,
+                                                           const juce::AudioFormatReader& source)
+    {
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+
+        if (auto stream = file.createOutputStream())
+        {
+            writer.reset (format.createWriterFor (stream.get(), source.sampleRate, source.numChannels,
+                                                  pickBitDepth (format, (int) source.bitsPerSample),
+                                                  source.metadataValues, 0));
+
+            if (writer != nullptr)
+                stream.release();
+        }
+
+        return writer;
+    }
+
+    //==============================================================================
+    FileRenderer::FileRenderer (const RenderOptions& optionsToUse)
+        : options (optionsToUse)
+    {
+        formats.registerBasicFormats();
+        applyOptions (processor, options);
+    }
+
+    FileReport FileRenderer::render (const juce::File& input)
+    {
+        return render (input, getOutputFile (options, input));
+    }
+
+    FileReport FileRenderer::render (const juce::File& input, const juce::File& output)
+    {
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        FileReport report;
+        report.input = input;
+        report.output = output;
+
+        if (report.output == input)
+            return failed (report, "output would overwrite the input");
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (input));
+
+        if (reader == nullptr)
+            return failed (report, "not a readable WAV, AIFF or FLAC file");
+
+        report.sampleRate = reader->sampleRate;
+        report.numChannels = (int) reader->numChannels;
+        report.numSamples = reader->lengthInSamples;
+
+        auto* format = formats.findFormatForFileExtension (report.output.getFileExtension());
+
+        if (format == nullptr)
+            return failed (report, "no writer for " + report.output.getFileExtension());
+
+        juce::TemporaryFile temporary (report.output);
+        auto writer = createWriter (*format, temporary.getFile(), *reader);
+
+        if (writer == nullptr)
+            return failed (report, "could not create " + report.output.getFullPathName());
+
+        const auto blockSize = options.blockSize;
+        const auto prepared = prepareProcessor (processor, report.numChannels, reader->sampleRate, blockSize);
+
+        if (prepared.failed())
+            return failed (report, prepared.getErrorMessage());
+
+        // The first `latency` samples out are the processor's delay; the input is padded with
+        // as much silence at the end so the output keeps the length of the input
+        const auto latency = (juce::int64) processor.getLatencySamples();
+        const auto totalToProcess = report.numSamples + latency;
+
+        juce::AudioBuffer<float> buffer (report.numChannels, blockSize);
+        juce::AudioBuffer<double> processing (report.numChannels, blockSize);
+        juce::MidiBuffer midi;
+        juce::int64 processTicks = 0;
+        auto writeOk = true;
+
+        for (juce::int64 position = 0; position < totalToProcess && writeOk; position += blockSize)
+        {
+            const auto numSamples = (int) juce::jmin ((juce::int64) blockSize, totalToProcess - position);
+            buffer.setSize (report.numChannels, numSamples, false, false, true);
+
+            // Reads past the end come back as silence
+            reader->read (&buffer, 0, numSamples, position, true, true);
+
+            processing.makeCopyOf (buffer, true);
+
+            const auto blockStart = juce::Time::getHighResolutionTicks();
+            processor.processBlock (processing, midi);
+            processTicks += juce::Time::getHighResolutionTicks() - blockStart;
+
+            buffer.makeCopyOf (processing, true);
+
+            const auto skip = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numSamples, latency - position);
+
+            if (skip < numSamples)
+                writeOk = writer->writeFromAudioSampleBuffer (buffer, skip, numSamples - skip);
+        }
+
+        processor.releaseResources();
+        writer.reset();
+
+        if (! writeOk || ! temporary.overwriteTargetFileWithTemporary())
+            return failed (report, "could not write " + report.output.getFullPathName());
+
+        report.processSeconds = juce::Time::highResolutionTicksToSeconds (processTicks);
+        report.totalSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        return report;
+    }
+
+    //==============================================================================
+    namespace
+    {
+        /** One per thread of the pool; takes the next file until there are none left. */
+        class RenderWorker  : public juce::ThreadPoolJob
+        {
+        public:
+            RenderWorker (const RenderOptions& options, const juce::Array<juce::File>& inputsToUse,
+                          std::atomic<int>& nextInputToUse, std::vector<FileReport>& reportsToFill,
+                          const std::function<void (const FileReport&)>& fileFinishedToCall)
+                : juce::ThreadPoolJob ("EZEQ render worker"),
+                  renderer (options),
+                  inputs (inputsToUse),
+                  nextInput (nextInputToUse),
+                  reports (reportsToFill),
+                  fileFinished (fileFinishedToCall)
+            {
+            }
+
+            JobStatus runJob() override
+            {
+                for (auto index = nextInput++; index < inputs.size() && ! shouldExit(); index = nextInput++)
+                {
+                    // Every worker writes its own slots only
+                    reports[(size_t) index] = renderer.render (inputs[index]);
+
+                    if (fileFinished != nullptr)
+                        fileFinished (reports[(size_t) index]);
+                }
+
+                return jobHasFinished;
+            }
+
+        private:
+            FileRenderer renderer;
+            const juce::Array<juce::File>& inputs;
+            std::atomic<int>& nextInput;
+            std::vector<FileReport>& reports;
+            const std::function<void (const FileReport&)>& fileFinished;
+        };
+    }
+
+    std::vector<FileReport> renderFiles (const juce::Array<juce::File>& inputs, const RenderOptions& options,
+                                         std::function<void (const FileReport&)> fileFinished)
+    {
+        std::vector<FileReport> reports ((size_t) inputs.size());
+        std::atomic<int> nextInput { 0 };
+
+        const auto numWorkers = juce::jlimit (1, juce::jmax (1, inputs.size()), options.numThreads);
+
+        // The processors are built here, on the message thread, before any of them runs
+        juce::OwnedArray<RenderWorker> workers;
+
+        for (int i = 0; i < numWorkers; ++i)
+            workers.add (new RenderWorker (options, inputs, nextInput, reports, fileFinished));
+
+        juce::ThreadPool pool (numWorkers);
+
+        for (auto* worker : workers)
+            pool.addJob (worker, false);
+
+        for (auto* worker : workers)
+            pool.waitForJobToFinish (worker, -1);
+
+        return reports;
+    }
+}
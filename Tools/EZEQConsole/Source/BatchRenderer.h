@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    BatchRenderer.h
+    Offline rendering of audio files through the EQ, one processor per worker.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+namespace Console
+{
+    /** What every file is rendered with. */
+    struct RenderOptions
+    {
+        // A preset's state tree, applied first; invalid means the defaults
+        juce::ValueTree preset;
+
+        // Plain values from the command line, applied on top of the preset
+        SimpleEQAudioProcessor::ParameterValues parameters;
+
+        // Empty means next to each input
+        juce::File outputDirectory;
+        juce::String suffix { "_ezeq" };
+
+        int blockSize = 16384;
+        int numThreads = 1;
+    };
+
+    /** The outcome of one file. */
+    struct FileReport
+    {
+        juce::File input, output;
+        double sampleRate = 0.0;
+        int numChannels = 0;
+        juce::int64 numSamples = 0;
+
+        // processBlock alone, and everything including decoding and encoding
+        double processSeconds = 0.0, totalSeconds = 0.0;
+
+        // Chunked renders: how many chunks ran in parallel, and for how many samples the
+        // stitching had to carry a chunk's predecessor's ringing into it
+        int numChunks = 1;
+        juce::int64 stitchedSamples = 0;
+
+        juce::String error;
+
+        bool wasSuccessful() const noexcept         { return error.isEmpty(); }
+        double getAudioSeconds() const noexcept     { return sampleRate > 0.0 ? (double) numSamples / sampleRate : 0.0; }
+
+        /** Seconds of audio per second of processing; 0 if nothing was timed. */
+        double getProcessRealtimeFactor() const noexcept    { return processSeconds > 0.0 ? getAudioSeconds() / processSeconds : 0.0; }
+        double getTotalRealtimeFactor() const noexcept      { return totalSeconds > 0.0 ? getAudioSeconds() / totalSeconds : 0.0; }
+    };
+
+    //==============================================================================
+    /** Applies the preset and parameters of the options, and sets the processor up for offline use. */
+    void applyOptions (SimpleEQAudioProcessor& processor, const RenderOptions& options);
+
+    /** Same layout in and out, as the plugin requires, then prepared for the block size.
+        Call it after applyOptions(): in linear phase the kernel for the options is installed
+        here, so rendering can start straight away.
+    */
+    juce::Result prepareProcessor (SimpleEQAudioProcessor& processor, int numChannels, double sampleRate, int blockSize);
+
+    /** Where the render of input goes. */
+    juce::File getOutputFile (const RenderOptions& options, const juce::File& input);
+
+    /** A writer into file with the source's rate and channels, and its bit depth where the
+        format has it.
+    */
+    std::unique_ptr<juce::AudioFormatWriter> createWriter (juce::AudioFormat& format, const juce::File& file,
+                                                           const juce::AudioFormatReader& source);
+
+    //==============================================================================
+    /**
+        Streams files through one SimpleEQAudioProcessor, a block at a time.
+
+        The processor is set up for each file's channel count and rate, in double precision,
+        and prepared for the configured block size. Its latency is compensated, so the output lines up with the input
+        sample for sample and has the same length. Output is written next to the input (or to
+        the output directory) in the same format, through a temporary file, so a failed render
+        never leaves half a file behind.
+
+        Create it on the message thread; render() can then run on any one thread at a time.
+    */
+    class FileRenderer
+    {
+    public:
+        explicit FileRenderer (const RenderOptions& optionsToUse);
+
+        FileReport render (const juce::File& input);
+        FileReport render (const juce::File& input, const juce::File& output);
+
+    private:
+        const RenderOptions& options;
+        juce::AudioFormatManager formats;
+        SimpleEQAudioProcessor processor;
+
+        JUCE_DECLARE_NON_COPYABLE (FileRenderer)
+    };
+
+    //==============================================================================
+    /** Renders the files on options.numThreads workers, each with its own processor, and
+        calls fileFinished from the worker as each one completes.
+        @returns a report per file, in the order of the inputs.
+    */
+    std::vector<FileReport> renderFiles (const juce::Array<juce::File>& inputs, const RenderOptions& options,
+                                         std::function<void (const FileReport&)> fileFinished);
+}
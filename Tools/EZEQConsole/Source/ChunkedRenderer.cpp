@@ -0,0 +1,311 @@
+/*
+  ==============================================================================
+
+    ChunkedRenderer.cpp
+    One long file rendered in parallel chunks, stitched back to a serial render.
+
+  ==============================================================================
+*/
+
+#include "ChunkedRenderer.h"
+
+namespace Console
+{
+    namespace
+    {
+        // Shorter chunks aren't worth a worker
+        constexpr double minimumChunkSeconds = 10.0;
+
+        // Ringing from a state this small can't move a float sample any more, not even a
+        // denormal one, with room to spare for the gain the bands can add on top
+        constexpr double negligibleState = 1.0e-50;
+
+        /** Renders one chunk from silent filters into a float WAV and keeps the state it ends in. */
+        class ChunkJob  : public juce::ThreadPoolJob
+        {
+        public:
+            ChunkJob (const RenderOptions& optionsToUse, const juce::File& inputToUse, juce::int64 startToUse, juce::int64 lengthToUse)
+                : juce::ThreadPoolJob ("EZEQ chunk"),
+                  options (optionsToUse),
+                  input (inputToUse),
+                  start (startToUse),
+                  length (lengthToUse),
+                  output (".wav")
+            {
+                formats.registerBasicFormats();
+                applyOptions (processor, options);
+            }
+
+            JobStatus runJob() override
+            {
+                std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (input));
+
+                if (reader == nullptr)
+                {
+                    error = "could not read " + input.getFullPathName();
+                    return jobHasFinished;
+                }
+
+                const auto prepared = prepareProcessor (processor, (int) reader->numChannels, reader->sampleRate, options.blockSize);
+
+                if (prepared.failed())
+                {
+                    error = prepared.getErrorMessage();
+                    return jobHasFinished;
+                }
+
+                // Float, so the chunk comes back exactly as it was rendered
+                std::unique_ptr<juce::AudioFormatWriter> writer;
+                juce::WavAudioFormat wav;
+
+                if (auto stream = output.getFile().createOutputStream())
+                {
+                    writer.reset (wav.createWriterFor (stream.get(), reader->sampleRate, reader->numChannels, 32, {}, 0));
+
+                    if (writer != nullptr)
+                        stream.release();
+                }
+
+                if (writer == nullptr)
+                {
+                    error = "could not create " + output.getFile().getFullPathName();
+                    return jobHasFinished;
+                }
+
+                juce::AudioBuffer<float> buffer ((int) reader->numChannels, options.blockSize);
+                juce::AudioBuffer<double> processing ((int) reader->numChannels, options.blockSize);
+                juce::MidiBuffer midi;
+
+                for (juce::int64 position = 0; position < length && ! shouldExit(); position += options.blockSize)
+                {
+                    const auto numSamples = (int) juce::jmin ((juce::int64) options.blockSize, length - position);
+                    buffer.setSize ((int) reader->numChannels, numSamples, false, false, true);
+                    reader->read (&buffer, 0, numSamples, start + position, true, true);
+                    processing.makeCopyOf (buffer, true);
+
+                    const auto blockStart = juce::Time::getHighResolutionTicks();
+                    processor.processBlock (processing, midi);
+                    processTicks += juce::Time::getHighResolutionTicks() - blockStart;
+
+                    buffer.makeCopyOf (processing, true);
+
+                    if (! writer->writeFromAudioSampleBuffer (buffer, 0, numSamples))
+                    {
+                        error = "could not write " + output.getFile().getFullPathName();
+                        return jobHasFinished;
+                    }
+                }
+
+                processor.saveFilterState (endState);
+                return jobHasFinished;
+            }
+
+            const RenderOptions& options;
+            const juce::File input;
+            const juce::int64 start, length;
+
+            juce::AudioFormatManager formats;
+            SimpleEQAudioProcessor processor;
+
+            juce::TemporaryFile output;
+            SimpleEQAudioProcessor::FilterState endState;
+            juce::int64 processTicks = 0;
+            juce::String error;
+        };
+
+        FileReport failed (FileReport report, const juce::String& error)
+        {
+            report.error = error;
+            return report;
+        }
+    }
+
+    //==============================================================================
+    FileReport renderChunked (const juce::File& input, const RenderOptions& options)
+    {
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        FileReport report;
+        report.input = input;
+        report.output = getOutputFile (options, input);
+
+        if (report.output == input)
+            return failed (report, "output would overwrite the input");
+
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (input));
+
+        if (reader == nullptr)
+            return failed (report, "not a readable WAV, AIFF or FLAC file");
+
+        report.sampleRate = reader->sampleRate;
+        report.numChannels = (int) reader->numChannels;
+        report.numSamples = reader->lengthInSamples;
+
+        const auto maxChunks = (int) (report.getAudioSeconds() / minimumChunkSeconds);
+        const auto numChunks = juce::jlimit (1, juce::jmax (1, maxChunks), options.numThreads);
+
+        // Built here, on the message thread, like every processor of the tool
+        juce::OwnedArray<ChunkJob> chunks;
+
+        for (int i = 0; i < numChunks; ++i)
+        {
+            const auto chunkStart = report.numSamples * i / numChunks;
+            const auto chunkEnd = report.numSamples * (i + 1) / numChunks;
+            chunks.add (new ChunkJob (options, input, chunkStart, chunkEnd - chunkStart));
+        }
+
+        if (! chunks.getFirst()->processor.canCheckpointFilterState())
+        {
+            chunks.clear();
+
+            FileRenderer renderer (options);
+            return renderer.render (input, report.output);
+        }
+
+        {
+            juce::ThreadPool pool (numChunks);
+
+            for (auto* chunk : chunks)
+                pool.addJob (chunk, false);
+
+            for (auto* chunk : chunks)
+                pool.waitForJobToFinish (chunk, -1);
+        }
+
+        juce::int64 processTicks = 0;
+
+        for (auto* chunk : chunks)
+        {
+            if (chunk->error.isNotEmpty())
+                return failed (report, chunk->error);
+
+            processTicks += chunk->processTicks;
+        }
+
+        auto* format = formats.findFormatForFileExtension (report.output.getFileExtension());
+
+        if (format == nullptr)
+            return failed (report, "no writer for " + report.output.getFileExtension());
+
+        juce::TemporaryFile temporary (report.output);
+        auto writer = createWriter (*format, temporary.getFile(), *reader);
+
+        if (writer == nullptr)
+            return failed (report, "could not create " + report.output.getFullPathName());
+
+        // The first chunk's processor, still prepared, runs the ringing between chunks
+        auto& stitcher = chunks.getFirst()->processor;
+        const auto blockSize = options.blockSize;
+
+        juce::AudioBuffer<float> audio (report.numChannels, blockSize);
+        juce::AudioBuffer<double> sum (report.numChannels, blockSize), ringing (report.numChannels, blockSize);
+        juce::MidiBuffer midi;
+        juce::WavAudioFormat wav;
+
+        // The true filter state at the start of the chunk; the first one starts from silence
+        SimpleEQAudioProcessor::FilterState incoming, remaining;
+
+        for (auto* chunk : chunks)
+        {
+            std::unique_ptr<juce::AudioFormatReader> chunkReader (wav.createReaderFor (chunk->output.getFile().createInputStream().release(), true));
+
+            if (chunkReader == nullptr)
+                return failed (report, "could not read back " + chunk->output.getFile().getFullPathName());
+
+            auto isRinging = incoming.getPeak() > negligibleState;
+
+            if (isRinging)
+                stitcher.restoreFilterState (incoming);
+
+            for (juce::int64 position = 0; position < chunk->length; position += blockSize)
+            {
+                const auto numSamples = (int) juce::jmin ((juce::int64) blockSize, chunk->length - position);
+                audio.setSize (report.numChannels, numSamples, false, false, true);
+                chunkReader->read (&audio, 0, numSamples, position, true, true);
+
+                if (isRinging)
+                {
+                    ringing.setSize (report.numChannels, numSamples, false, false, true);
+                    ringing.clear();
+
+                    const auto blockStart = juce::Time::getHighResolutionTicks();
+                    stitcher.processBlock (ringing, midi);
+                    processTicks += juce::Time::getHighResolutionTicks() - blockStart;
+
+                    // The chunk was rounded to float once already, so stitched samples may differ by one float step
+                    sum.makeCopyOf (audio, true);
+
+                    for (int channel = 0; channel < report.numChannels; ++channel)
+                        sum.addFrom (channel, 0, ringing, channel, 0, numSamples);
+
+                    audio.makeCopyOf (sum, true);
+                    report.stitchedSamples += numSamples;
+
+                    stitcher.saveFilterState (remaining);
+                    isRinging = remaining.getPeak() > negligibleState;
+                }
+
+                if (! writer->writeFromAudioSampleBuffer (audio, 0, numSamples))
+                    return failed (report, "could not write " + report.output.getFullPathName());
+            }
+
+            // The next chunk starts from this chunk's own end state plus whatever of the
+            // incoming state is still ringing at its end
+            incoming = chunk->endState;
+
+            if (isRinging)
+                for (size_t i = 0; i < incoming.values.size(); ++i)
+                    incoming.values[i] += remaining.values[i];
+        }
+
+        stitcher.releaseResources();
+        writer.reset();
+
+        if (! temporary.overwriteTargetFileWithTemporary())
+            return failed (report, "could not write " + report.output.getFullPathName());
+
+        report.numChunks = numChunks;
+        report.processSeconds = juce::Time::highResolutionTicksToSeconds (processTicks);
+        report.totalSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        return report;
+    }
+
+    double findLargestDifference (const juce::File& a, const juce::File& b)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> readerA (formats.createReaderFor (a)), readerB (formats.createReaderFor (b));
+
+        if (readerA == nullptr || readerB == nullptr
+             || readerA->numChannels != readerB->numChannels
+             || readerA->lengthInSamples != readerB->lengthInSamples)
+            return -1.0;
+
+        constexpr int blockSize = 65536;
+        const auto numChannels = (int) readerA->numChannels;
+        juce::AudioBuffer<float> bufferA (numChannels, blockSize), bufferB (numChannels, blockSize);
+        auto largest = 0.0;
+
+        for (juce::int64 position = 0; position < readerA->lengthInSamples; position += blockSize)
+        {
+            const auto numSamples = (int) juce::jmin ((juce::int64) blockSize, readerA->lengthInSamples - position);
+            readerA->read (&bufferA, 0, numSamples, position, true, true);
+            readerB->read (&bufferB, 0, numSamples, position, true, true);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                const auto* x = bufferA.getReadPointer (channel);
+                const auto* y = bufferB.getReadPointer (channel);
+
+                for (int i = 0; i < numSamples; ++i)
+                    largest = juce::jmax (largest, (double) std::abs (x[i] - y[i]));
+            }
+        }
+
+        return largest;
+    }
+}
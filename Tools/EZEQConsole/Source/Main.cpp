@@ -0,0 +1,300 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Headless EZEQ: renders audio files through the EQ without a host.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ChunkedRenderer.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "usage: EZEQConsole [options] <file or directory>..." << std::endl
+                  << std::endl
+                  << "  --preset <file>          start from a saved .preset" << std::endl
+                  << "  --set <ID>=<value>       one parameter as a plain value, e.g. Freq2=1200; repeatable" << std::endl
+                  << "  --output <directory>     write the renders here instead of next to the inputs" << std::endl
+                  << "  --suffix <text>          appended to the output names (default _ezeq)" << std::endl
+                  << "  --threads <n>            workers, one processor each (default: one per core)" << std::endl
+                  << "  --block <samples>        block size handed to processBlock (default 16384)" << std::endl
+                  << "  --chunked                renders each file in parallel chunks instead of files in parallel" << std::endl
+                  << "  --verify                 with --chunked, compares every result with a serial render" << std::endl
+                  << "  --parameters             lists the parameter IDs and ranges" << std::endl;
+    }
+
+    void printParameters()
+    {
+        SimpleEQAudioProcessor processor;
+
+        for (auto* parameter : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            {
+                const auto& range = ranged->getNormalisableRange();
+                std::cout << ranged->paramID.paddedRight (' ', 20)
+                          << range.start << " .. " << range.end
+                          << ", default " << range.convertFrom0to1 (ranged->getDefaultValue()) << std::endl;
+            }
+    }
+
+    juce::String formatDuration (double seconds)
+    {
+        const auto minutes = (int) (seconds / 60.0);
+        return juce::String (minutes) + ":" + juce::String (seconds - minutes * 60.0, 1).paddedLeft ('0', 4);
+    }
+
+    void printReport (const Console::FileReport& report)
+    {
+        std::cout << report.input.getFileName() << ": ";
+
+        if (! report.wasSuccessful())
+        {
+            std::cout << "failed, " << report.error << std::endl;
+            return;
+        }
+
+        std::cout << formatDuration (report.getAudioSeconds()) << ", "
+                  << report.numChannels << " ch, " << juce::String (report.sampleRate / 1000.0, 1) << " kHz, "
+                  << juce::String (report.getProcessRealtimeFactor(), 1) << "x realtime processing, "
+                  << juce::String (report.getTotalRealtimeFactor(), 1) << "x with file I/O";
+
+        if (report.numChunks > 1)
+            std::cout << ", " << report.numChunks << " chunks stitched over "
+                      << juce::String (1000.0 * (double) report.stitchedSamples / report.sampleRate, 1) << " ms";
+
+        std::cout << std::endl;
+    }
+
+    /** Renders the input once more, serially, and prints how far the chunked render is from it. */
+    void verifyAgainstSerialRender (const Console::FileReport& report, const Console::RenderOptions& options)
+    {
+        juce::TemporaryFile serialOutput (report.output);
+        Console::FileRenderer renderer (options);
+        const auto serial = renderer.render (report.input, serialOutput.getFile());
+
+        const auto difference = serial.wasSuccessful() ? Console::findLargestDifference (report.output, serialOutput.getFile())
+                                                       : -1.0;
+
+        if (difference < 0.0)
+            std::cout << "    verify: could not compare with a serial render" << std::endl;
+        else if (difference == 0.0)
+            std::cout << "    verify: identical to a serial render" << std::endl;
+        else
+            std::cout << "    verify: differs from a serial render by at most "
+                      << juce::String (juce::Decibels::gainToDecibels (difference, -400.0), 1) << " dBFS" << std::endl;
+    }
+
+    double getMedian (std::vector<double> values)
+    {
+        if (values.empty())
+            return 0.0;
+
+        std::sort (values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    // The processor starts timers and owns message thread objects, so it needs a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    Console::RenderOptions options;
+    options.numThreads = juce::SystemStats::getNumCpus();
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    juce::Array<juce::File> inputs;
+    auto chunked = false, verify = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg (argv[i]);
+        const auto hasValue = i + 1 < argc;
+
+        if (arg == "--parameters")
+        {
+            printParameters();
+            return 0;
+        }
+
+        if (arg == "--chunked" || arg == "--verify")
+        {
+            (arg == "--chunked" ? chunked : verify) = true;
+            continue;
+        }
+
+        if (arg.startsWith ("--") && ! hasValue)
+        {
+            printUsage();
+            return 1;
+        }
+
+        if (arg == "--preset")
+        {
+            const auto presetFile = juce::File::getCurrentWorkingDirectory().getChildFile (argv[++i]);
+
+            if (auto xml = juce::XmlDocument::parse (presetFile))
+                options.preset = juce::ValueTree::fromXml (*xml);
+
+            if (! options.preset.isValid())
+            {
+                std::cout << "error: could not read the preset " << presetFile.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--set")
+        {
+            const juce::String assignment (argv[++i]);
+
+            if (! assignment.containsChar ('='))
+            {
+                printUsage();
+                return 1;
+            }
+
+            options.parameters[assignment.upToFirstOccurrenceOf ("=", false, false).trim()]
+                = assignment.fromFirstOccurrenceOf ("=", false, false).getFloatValue();
+        }
+        else if (arg == "--output")
+        {
+            options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile (argv[++i]);
+
+            if (! options.outputDirectory.createDirectory())
+            {
+                std::cout << "error: could not create " << options.outputDirectory.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--suffix")
+        {
+            options.suffix = argv[++i];
+        }
+        else if (arg == "--threads")
+        {
+            options.numThreads = juce::jmax (1, juce::String (argv[++i]).getIntValue());
+        }
+        else if (arg == "--block")
+        {
+            options.blockSize = juce::jlimit (64, 1 << 20, juce::String (argv[++i]).getIntValue());
+        }
+        else if (arg.startsWith ("--"))
+        {
+            printUsage();
+            return 1;
+        }
+        else
+        {
+            const auto file = juce::File::getCurrentWorkingDirectory().getChildFile (arg);
+
+            // Directories contribute the audio files directly inside them
+            if (file.isDirectory())
+            {
+                auto files = file.findChildFiles (juce::File::findFiles, false, formats.getWildcardForAllFormats());
+                files.sort();
+                inputs.addArray (files);
+            }
+            else
+            {
+                inputs.add (file);
+            }
+        }
+    }
+
+    if (inputs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    // IDs the processor doesn't know would be silently ignored
+    {
+        SimpleEQAudioProcessor processor;
+
+        for (const auto& [parameterID, value] : options.parameters)
+            if (processor.apvts.getParameter (parameterID) == nullptr)
+            {
+                std::cout << "error: no parameter " << parameterID << ", see --parameters" << std::endl;
+                return 1;
+            }
+    }
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    std::vector<Console::FileReport> reports;
+    juce::int64 verifyTicks = 0;
+
+    if (chunked)
+    {
+        std::cout << "rendering " << inputs.size() << " files one after another, each in up to "
+                  << options.numThreads << " chunks" << std::endl;
+
+        for (const auto& input : inputs)
+        {
+            reports.push_back (Console::renderChunked (input, options));
+            printReport (reports.back());
+
+            // Not part of the timing
+            if (verify && reports.back().wasSuccessful())
+            {
+                const auto verifyStart = juce::Time::getHighResolutionTicks();
+                verifyAgainstSerialRender (reports.back(), options);
+                verifyTicks += juce::Time::getHighResolutionTicks() - verifyStart;
+            }
+        }
+    }
+    else
+    {
+        std::cout << "rendering " << inputs.size() << " files on "
+                  << juce::jmin (options.numThreads, inputs.size()) << " workers" << std::endl;
+
+        juce::CriticalSection printLock;
+
+        reports = Console::renderFiles (inputs, options, [&] (const Console::FileReport& report)
+        {
+            const juce::ScopedLock lock (printLock);
+            printReport (report);
+        });
+    }
+
+    const auto wallSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks - verifyTicks);
+
+    std::vector<double> processFactors, totalFactors;
+    auto audioSeconds = 0.0;
+    auto numFailed = 0;
+
+    for (const auto& report : reports)
+    {
+        if (! report.wasSuccessful())
+        {
+            ++numFailed;
+            continue;
+        }
+
+        audioSeconds += report.getAudioSeconds();
+        processFactors.push_back (report.getProcessRealtimeFactor());
+        totalFactors.push_back (report.getTotalRealtimeFactor());
+    }
+
+    std::cout << std::endl
+              << "files:               " << (int) processFactors.size() << " rendered, " << numFailed << " failed" << std::endl
+              << "audio:               " << formatDuration (audioSeconds) << " in " << juce::String (wallSeconds, 2) << " s, "
+              << juce::String (60.0 * (double) processFactors.size() / juce::jmax (wallSeconds, 1.0e-9), 1) << " files per minute, "
+              << juce::String (audioSeconds / juce::jmax (wallSeconds, 1.0e-9), 1) << "x realtime overall" << std::endl;
+
+    if (! processFactors.empty())
+    {
+        const auto [minProcess, maxProcess] = std::minmax_element (processFactors.begin(), processFactors.end());
+
+        std::cout << "per file processing: " << juce::String (*minProcess, 1) << "x min, "
+                  << juce::String (getMedian (processFactors), 1) << "x median, "
+                  << juce::String (*maxProcess, 1) << "x max realtime" << std::endl
+                  << "per file with I/O:   " << juce::String (getMedian (totalFactors), 1) << "x median realtime" << std::endl;
+    }
+
+    return numFailed == 0 ? 0 : 1;
+}